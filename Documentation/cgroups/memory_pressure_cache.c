@@ -0,0 +1,192 @@
+/*
+ * memory_pressure_cache.c - A userspace cache driven by memory pressure
+ *
+ * The program keeps growing a cache of 1MB chunks and registers for the
+ * three memory.pressure_level notifications of a memory cgroup.  On
+ * "low" it trims the oldest eighth of the cache, on "medium" half of it,
+ * and on "critical" all of it.  The cache size is printed along with the
+ * swap in use, to show that the cache settles below the point where the
+ * kernel would start swapping or invoking the OOM killer.
+ *
+ * Usage: memory_pressure_cache <cgroup directory> [max MB [seconds]]
+ *
+ * See Documentation/cgroups/memory.txt, section 11.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/eventfd.h>
+
+#define USAGE_STR "Usage: memory_pressure_cache <cgroup> [max MB [seconds]]\n"
+#define CHUNK (1UL << 20)
+
+enum { LOW, MEDIUM, CRITICAL, NR_LEVELS };
+
+static const char *level_names[NR_LEVELS] = { "low", "medium", "critical" };
+
+/* Share of the cache, in eighths, dropped on each level */
+static const unsigned long level_drop[NR_LEVELS] = { 1, 4, 8 };
+
+static char **cache;
+static unsigned long cache_head, cache_len, cache_max;
+
+static int register_level(const char *cgroup, int level)
+{
+	char path[PATH_MAX], line[LINE_MAX];
+	int efd, cfd, ecfd, ret;
+
+	snprintf(path, sizeof(path), "%s/memory.pressure_level", cgroup);
+	cfd = open(path, O_RDONLY);
+	if (cfd == -1) {
+		fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+		exit(1);
+	}
+
+	snprintf(path, sizeof(path), "%s/cgroup.event_control", cgroup);
+	ecfd = open(path, O_WRONLY);
+	if (ecfd == -1) {
+		fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+		exit(1);
+	}
+
+	efd = eventfd(0, 0);
+	if (efd == -1) {
+		perror("eventfd() failed");
+		exit(1);
+	}
+
+	snprintf(line, sizeof(line), "%d %d %s", efd, cfd, level_names[level]);
+	ret = write(ecfd, line, strlen(line) + 1);
+	if (ret == -1) {
+		perror("Cannot write to cgroup.event_control");
+		exit(1);
+	}
+
+	close(ecfd);
+	return efd;
+}
+
+static unsigned long swap_used_mb(void)
+{
+	unsigned long total = 0, free = 0, val;
+	char line[128];
+	FILE *f;
+
+	f = fopen("/proc/meminfo", "r");
+	if (!f)
+		return 0;
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, "SwapTotal: %lu kB", &val) == 1)
+			total = val;
+		else if (sscanf(line, "SwapFree: %lu kB", &val) == 1)
+			free = val;
+	}
+	fclose(f);
+	return (total - free) >> 10;
+}
+
+static void cache_grow(void)
+{
+	char *chunk = malloc(CHUNK);
+
+	if (!chunk)
+		return;
+	/* Touch the memory, an untouched chunk costs nothing */
+	memset(chunk, 0x5a, CHUNK);
+	cache[(cache_head + cache_len) % cache_max] = chunk;
+	cache_len++;
+}
+
+static void cache_shrink(unsigned long nr)
+{
+	while (nr-- && cache_len) {
+		free(cache[cache_head]);
+		cache_head = (cache_head + 1) % cache_max;
+		cache_len--;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	struct pollfd fds[NR_LEVELS];
+	unsigned long seconds = 60;
+	time_t start, last = 0;
+	int level;
+
+	if (argc < 2 || argc > 4) {
+		fputs(USAGE_STR, stderr);
+		return 1;
+	}
+	cache_max = argc > 2 ? strtoul(argv[2], NULL, 0) : 1024;
+	if (argc > 3)
+		seconds = strtoul(argv[3], NULL, 0);
+
+	cache = calloc(cache_max, sizeof(*cache));
+	if (!cache || !cache_max) {
+		fputs(USAGE_STR, stderr);
+		return 1;
+	}
+
+	for (level = 0; level < NR_LEVELS; level++) {
+		fds[level].fd = register_level(argv[1], level);
+		fds[level].events = POLLIN;
+	}
+
+	start = time(NULL);
+	while (time(NULL) - start < (time_t)seconds) {
+		int ret, worst = -1;
+
+		/* Grow as long as nobody complains */
+		ret = poll(fds, NR_LEVELS, cache_len < cache_max ? 0 : 1000);
+		if (ret == -1) {
+			perror("poll() failed");
+			return 1;
+		}
+
+		for (level = 0; ret > 0 && level < NR_LEVELS; level++) {
+			uint64_t count;
+
+			if (!(fds[level].revents & POLLIN))
+				continue;
+			if (read(fds[level].fd, &count, sizeof(count)) !=
+			    sizeof(count)) {
+				perror("Cannot read from eventfd");
+				return 1;
+			}
+			worst = level;
+		}
+
+		if (worst >= 0) {
+			unsigned long before = cache_len;
+
+			cache_shrink((cache_len * level_drop[worst] + 7) / 8);
+			printf("%-8s cache %5lu MB -> %5lu MB, swap used %lu MB\n",
+			       level_names[worst], before, cache_len,
+			       swap_used_mb());
+			/* Give reclaim a moment to catch up */
+			usleep(100000);
+			continue;
+		}
+
+		if (cache_len < cache_max)
+			cache_grow();
+
+		if (time(NULL) != last) {
+			last = time(NULL);
+			printf("         cache %5lu MB, swap used %lu MB\n",
+			       cache_len, swap_used_mb());
+		}
+	}
+
+	cache_shrink(cache_len);
+	return 0;
+}
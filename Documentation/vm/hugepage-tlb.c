@@ -0,0 +1,139 @@
+/*
+ * TLB miss benchmark: compares random accesses to small page and huge
+ * page memory.
+ *
+ * The buffer is walked as a random cyclic chain with one hop per small
+ * page, so nearly every access needs a translation the TLB does not
+ * hold, while the data cache footprint stays the same for both kinds
+ * of mapping.  The time per access and the speedup given by huge pages
+ * are printed.  Huge pages are taken with MAP_HUGETLB; before running
+ * this program make sure the administrator has allocated enough
+ * default sized huge pages, e.g.
+ *
+ *	echo 32 > /proc/sys/vm/nr_hugepages
+ *
+ * Usage: hugepage-tlb [megabytes [accesses]]
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#ifndef MAP_HUGETLB
+#define MAP_HUGETLB 0x40000 /* arch specific */
+#endif
+
+#define PROTECTION (PROT_READ | PROT_WRITE)
+#define LINE 64
+
+static unsigned long seed = 1;
+
+static unsigned long next_rand(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+/*
+ * Link every page into one random cycle.  The word used in each page
+ * moves around by a cache line, so that the walk does not hammer a
+ * single cache set.
+ */
+static void **build_chain(char *buf, unsigned long pages, long page_size)
+{
+	unsigned long *order, i, j, t;
+	void **p;
+
+	order = malloc(pages * sizeof(*order));
+	if (!order) {
+		perror("malloc");
+		exit(1);
+	}
+	for (i = 0; i < pages; i++)
+		order[i] = i;
+	for (i = pages - 1; i > 0; i--) {
+		j = next_rand() % (i + 1);
+		t = order[i];
+		order[i] = order[j];
+		order[j] = t;
+	}
+
+	for (i = 0; i < pages; i++) {
+		unsigned long from = order[i], to = order[(i + 1) % pages];
+
+		p = (void **)(buf + from * page_size + from * LINE % page_size);
+		*p = buf + to * page_size + to * LINE % page_size;
+	}
+	p = (void **)(buf + order[0] * page_size +
+		      order[0] * LINE % page_size);
+	free(order);
+	return p;
+}
+
+static double walk(void **p, unsigned long accesses)
+{
+	struct timespec t0, t1;
+	unsigned long i;
+
+	/* Warm up: fault everything in and fill the caches */
+	for (i = 0; i < accesses / 8; i++)
+		p = *p;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < accesses; i++)
+		p = *p;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	/* Keep the compiler from dropping the loop */
+	if (!p)
+		printf("\n");
+
+	return ((t1.tv_sec - t0.tv_sec) * 1e9 +
+		(t1.tv_nsec - t0.tv_nsec)) / accesses;
+}
+
+static double run(const char *name, unsigned long length, int flags,
+		  unsigned long accesses)
+{
+	long page_size = sysconf(_SC_PAGESIZE);
+	char *buf;
+	double ns;
+
+	buf = mmap(NULL, length, PROTECTION,
+		   MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+	if (buf == MAP_FAILED) {
+		perror(name);
+		return 0;
+	}
+
+	seed = 1;
+	ns = walk(build_chain(buf, length / page_size, page_size), accesses);
+	printf("%-12s %8.2f ns/access\n", name, ns);
+
+	munmap(buf, length);
+	return ns;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long mb = 64, accesses = 16UL << 20;
+	double small, huge;
+
+	if (argc > 1)
+		mb = strtoul(argv[1], NULL, 0);
+	if (argc > 2)
+		accesses = strtoul(argv[2], NULL, 0);
+	if (!mb || !accesses) {
+		fprintf(stderr, "usage: %s [megabytes [accesses]]\n", argv[0]);
+		exit(1);
+	}
+
+	printf("%lu MB, %lu random accesses\n", mb, accesses);
+	small = run("small pages", mb << 20, 0, accesses);
+	huge = run("huge pages", mb << 20, MAP_HUGETLB, accesses);
+	if (small && huge)
+		printf("speedup      %8.2fx\n", small / huge);
+
+	return 0;
+}
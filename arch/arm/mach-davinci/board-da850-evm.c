@@ -1252,6 +1252,9 @@ static __init int da850_wl12xx_init(void)
 #ifdef CONFIG_UIO_PRUSS
 struct uio_pruss_pdata da8xx_pruss_uio_pdata = {
 	.pintc_base	= 0x4000,
+	.pru_ctrl_base	= { 0x7000, 0x7800 },
+	.pru_iram_base	= { 0x8000, 0xc000 },
+	.pru_iram_size	= SZ_4K,
 };
 
 	ret = da8xx_register_pruss_uio(&da8xx_pruss_uio_pdata);
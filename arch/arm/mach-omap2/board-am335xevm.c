@@ -42,6 +42,9 @@
 #include <linux/w1-gpio.h>
 #include <linux/can/platform/mcp251x.h>
 #include <linux/input/ti_tscadc.h>
+#include <linux/async.h>
+#include <linux/slab.h>
+#include <linux/hrtimer.h>
 
 #include <sound/tlv320aic3x.h>
 
@@ -395,6 +398,16 @@ struct pinmux_config {
 	int val; /* Options for the mux register value */
 };
 
+/*
+* DEV_INIT_ASYNC devices are initialized concurrently with the rest of the
+* board, DEV_INIT_DEFERRED ones after all drivers have been registered.
+* Both are done before the root filesystem is mounted. Neither may touch
+* board state that the synchronous inits or other initcalls look at.
+*/
+#define DEV_INIT_SYNC		0
+#define DEV_INIT_ASYNC		1
+#define DEV_INIT_DEFERRED	2
+
 struct evm_dev_cfg {
 	void (*device_init)(int evm_id, int profile);
 
@@ -407,6 +420,8 @@ struct evm_dev_cfg {
 	u32 device_on;
 
 	u32 profile;	/* Profiles (0-7) in which the module is present */
+
+	u32 init_mode;	/* DEV_INIT_*, DEV_INIT_SYNC if left out */
 };
 
 /* AM335X - CPLD Register Offsets */
@@ -1532,6 +1547,128 @@ static struct platform_device beaglebone_lcd43_keys = {
 	},
 };
 
+/*
+ * Board device initialization.
+ *
+ * Every device init is timed; booting with initcall_debug prints the
+ * resulting trace once the deferred devices are done.
+ */
+struct am335x_dev_init {
+	struct list_head node;
+	void (*device_init)(int evm_id, int profile);
+	int evm_id;
+	int profile;
+};
+
+struct am335x_init_trace {
+	void (*device_init)(int evm_id, int profile);
+	u32 init_mode;
+	s64 start_us;
+	s64 duration_us;
+};
+
+#define AM335X_INIT_TRACE_MAX	48
+
+static struct am335x_init_trace am335x_init_trace[AM335X_INIT_TRACE_MAX];
+static unsigned int am335x_init_trace_cnt;
+static DEFINE_SPINLOCK(am335x_init_trace_lock);
+
+static LIST_HEAD(am335x_init_domain);
+/* Only touched by the board setup and, once it is done, the deferred init */
+static LIST_HEAD(am335x_deferred_list);
+
+static void am335x_dev_init_run(void (*device_init)(int, int), int evm_id,
+		int profile, u32 init_mode)
+{
+	struct am335x_init_trace *trace;
+	unsigned long flags;
+	ktime_t start;
+	s64 duration;
+
+	start = ktime_get();
+	device_init(evm_id, profile);
+	duration = ktime_us_delta(ktime_get(), start);
+
+	spin_lock_irqsave(&am335x_init_trace_lock, flags);
+	if (am335x_init_trace_cnt < AM335X_INIT_TRACE_MAX) {
+		trace = &am335x_init_trace[am335x_init_trace_cnt++];
+		trace->device_init = device_init;
+		trace->init_mode = init_mode;
+		trace->start_us = ktime_to_us(start);
+		trace->duration_us = duration;
+	}
+	spin_unlock_irqrestore(&am335x_init_trace_lock, flags);
+}
+
+static void am335x_init_report(void)
+{
+	static const char * const mode_name[] = {
+		[DEV_INIT_SYNC]		= "sync",
+		[DEV_INIT_ASYNC]	= "async",
+		[DEV_INIT_DEFERRED]	= "deferred",
+	};
+	struct am335x_init_trace *trace;
+	unsigned int i;
+
+	pr_info("AM335X: device init trace (start, duration in usecs):\n");
+	for (i = 0; i < am335x_init_trace_cnt; i++) {
+		trace = &am335x_init_trace[i];
+		pr_info("AM335X: %10lld %8lld %-8s %pf\n", trace->start_us,
+			trace->duration_us, mode_name[trace->init_mode],
+			trace->device_init);
+	}
+}
+
+static void am335x_dev_init_async(void *data, async_cookie_t cookie)
+{
+	struct am335x_dev_init *di = data;
+
+	am335x_dev_init_run(di->device_init, di->evm_id, di->profile,
+			DEV_INIT_ASYNC);
+	kfree(di);
+}
+
+static void am335x_deferred_init(void *data, async_cookie_t cookie)
+{
+	struct am335x_dev_init *di, *tmp;
+
+	list_for_each_entry_safe(di, tmp, &am335x_deferred_list, node) {
+		list_del(&di->node);
+		am335x_dev_init_run(di->device_init, di->evm_id, di->profile,
+				DEV_INIT_DEFERRED);
+		kfree(di);
+	}
+
+	if (initcall_debug)
+		am335x_init_report();
+}
+
+static void am335x_dev_init(struct evm_dev_cfg *dev_cfg, int evm_id,
+		int profile)
+{
+	struct am335x_dev_init *di;
+
+	if (dev_cfg->init_mode != DEV_INIT_SYNC) {
+		di = kzalloc(sizeof(*di), GFP_KERNEL);
+		if (di) {
+			di->device_init = dev_cfg->device_init;
+			di->evm_id = evm_id;
+			di->profile = profile;
+
+			if (dev_cfg->init_mode == DEV_INIT_ASYNC)
+				async_schedule_domain(am335x_dev_init_async,
+						di, &am335x_init_domain);
+			else
+				list_add_tail(&di->node,
+						&am335x_deferred_list);
+			return;
+		}
+	}
+
+	am335x_dev_init_run(dev_cfg->device_init, evm_id, profile,
+			DEV_INIT_SYNC);
+}
+
 /*
 * @evm_id - evm id which needs to be configured
 * @dev_cfg - single evm structure which includes
@@ -1557,22 +1694,39 @@ static void _configure_device(int evm_id, struct evm_dev_cfg *dev_cfg,
 	if (profile == PROFILE_NONE) {
 		for (i = 0; dev_cfg->device_init != NULL; dev_cfg++) {
 			if (dev_cfg->device_on == DEV_ON_BASEBOARD)
-				dev_cfg->device_init(evm_id, profile);
+				am335x_dev_init(dev_cfg, evm_id, profile);
 			else if (daughter_brd_detected == true)
-				dev_cfg->device_init(evm_id, profile);
+				am335x_dev_init(dev_cfg, evm_id, profile);
 		}
 	} else {
 		for (i = 0; dev_cfg->device_init != NULL; dev_cfg++) {
 			if (dev_cfg->profile & profile) {
 				if (dev_cfg->device_on == DEV_ON_BASEBOARD)
-					dev_cfg->device_init(evm_id, profile);
+					am335x_dev_init(dev_cfg, evm_id, profile);
 				else if (daughter_brd_detected == true)
-					dev_cfg->device_init(evm_id, profile);
+					am335x_dev_init(dev_cfg, evm_id, profile);
 			}
 		}
 	}
 }
 
+/*
+ * Wait for the asynchronous device initialization before the late
+ * initcalls below look at the board state it sets up, then start the
+ * deferred devices in the background.
+ */
+static int __init am335x_evm_late_init(void)
+{
+	if (!machine_is_am335xevm() && !machine_is_am335xiaevm())
+		return 0;
+
+	async_synchronize_full_domain(&am335x_init_domain);
+	async_schedule_domain(am335x_deferred_init, NULL, &am335x_init_domain);
+
+	return 0;
+}
+late_initcall(am335x_evm_late_init);
+
 
 /* pinmux for usb0 drvvbus */
 static struct pinmux_config usb0_pin_mux[] = {
@@ -3688,6 +3842,7 @@ static void tps65217_init(int evm_id, int profile)
 			" AC power is recommended.\n");
 		opp_disable(mpu_dev, 600000000);
 		opp_disable(mpu_dev, 720000000);
+		opp_disable(mpu_dev, 1000000000);
 	}
 }
 
@@ -3816,7 +3971,8 @@ static struct evm_dev_cfg gen_purp_evm_dev_cfg[] = {
 	{evm_nand_init, DEV_ON_DGHTR_BRD,
 		(PROFILE_ALL & ~PROFILE_2 & ~PROFILE_3)},
 	{i2c1_init,     DEV_ON_DGHTR_BRD, (PROFILE_ALL & ~PROFILE_2)},
-	{mcasp1_init,	DEV_ON_DGHTR_BRD, (PROFILE_0 | PROFILE_3 | PROFILE_7)},
+	{mcasp1_init,	DEV_ON_DGHTR_BRD, (PROFILE_0 | PROFILE_3 | PROFILE_7),
+						DEV_INIT_DEFERRED},
 	{mmc1_init,	DEV_ON_DGHTR_BRD, PROFILE_2},
 	{mmc2_wl12xx_init,	DEV_ON_BASEBOARD, (PROFILE_0 | PROFILE_3 |
 								PROFILE_5)},
@@ -3827,10 +3983,10 @@ static struct evm_dev_cfg gen_purp_evm_dev_cfg[] = {
 								PROFILE_5)},
 	{wl12xx_init,	DEV_ON_BASEBOARD, (PROFILE_0 | PROFILE_3 | PROFILE_5)},
 	{d_can_init,	DEV_ON_DGHTR_BRD, PROFILE_1},
-	{matrix_keypad_init, DEV_ON_DGHTR_BRD, PROFILE_0},
-	{volume_keys_init,  DEV_ON_DGHTR_BRD, PROFILE_0},
+	{matrix_keypad_init, DEV_ON_DGHTR_BRD, PROFILE_0, DEV_INIT_DEFERRED},
+	{volume_keys_init,  DEV_ON_DGHTR_BRD, PROFILE_0, DEV_INIT_DEFERRED},
 	{uart2_init,	DEV_ON_DGHTR_BRD, PROFILE_3},
-	{haptics_init,	DEV_ON_DGHTR_BRD, (PROFILE_4)},
+	{haptics_init,	DEV_ON_DGHTR_BRD, (PROFILE_4), DEV_INIT_DEFERRED},
 	{NULL, 0, 0},
 };
 
@@ -3871,13 +4027,17 @@ static struct evm_dev_cfg beaglebone_old_dev_cfg[] = {
 	{usb1_init,	DEV_ON_BASEBOARD, PROFILE_NONE},
 	{i2c2_init,	DEV_ON_BASEBOARD, PROFILE_NONE},
 	{mmc0_init,	DEV_ON_BASEBOARD, PROFILE_NONE},
-	{boneleds_init,	DEV_ON_BASEBOARD, PROFILE_ALL},
+	{boneleds_init,	DEV_ON_BASEBOARD, PROFILE_ALL, DEV_INIT_DEFERRED},
 	{NULL, 0, 0},
 };
 
 /* Beaglebone Rev A3 and after */
 static struct evm_dev_cfg beaglebone_dev_cfg[] = {
 	{tps65217_init,	DEV_ON_BASEBOARD, PROFILE_NONE},
+	/*
+	 * Cape setup from the EEPROM callback writes the beaglebone_* board
+	 * state and registers devices, so it must not run in the background
+	 */
 	{i2c2_init,	DEV_ON_BASEBOARD, PROFILE_NONE},
 	{mii1_init,	DEV_ON_BASEBOARD, PROFILE_NONE},
 	{usb0_init,	DEV_ON_BASEBOARD, PROFILE_NONE},
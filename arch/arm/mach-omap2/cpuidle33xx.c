@@ -29,6 +29,15 @@
 
 #include "cpuidle33xx.h"
 
+/*
+ * Only WFI and WFI + DDR self refresh are offered.  MPU clock gating and
+ * MPU power domain retention cannot be reached from here yet: the MPU
+ * clockdomain (mpu_am33xx_clkdm) has no CLKDM_CAN_HWSUP, so
+ * clkdm_allow_idle() is a no-op on it and WFI never gates the MPU clock,
+ * which in turn keeps mpu_pwrdm from entering retention.  Adding those states needs hardware supervised idle for the
+ * MPU clockdomain, checked on a board against the PM debug state
+ * counters, and exit latencies measured there.
+ */
 #define AM33XX_CPUIDLE_MAX_STATES	2
 
 struct am33xx_ops {
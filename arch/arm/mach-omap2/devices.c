@@ -1084,6 +1084,9 @@ static inline void am33xx_register_edma(void) {}
 #if defined (CONFIG_SOC_OMAPAM33XX)
 struct uio_pruss_pdata am335x_pruss_uio_pdata = {
 	.pintc_base	= 0x20000,
+	.pru_ctrl_base	= { 0x22000, 0x24000 },
+	.pru_iram_base	= { 0x34000, 0x38000 },
+	.pru_iram_size	= 0x2000,
 };
 
 static struct resource am335x_pruss_resources[] = {
@@ -14,6 +14,10 @@
 #include <linux/init.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
+#include <linux/sched.h>
 #include <mach/hardware.h>
 #include <asm/exception.h>
 #include <asm/mach/irq.h>
@@ -33,6 +37,7 @@
 #define INTC_MIR_CLEAR0		0x0088
 #define INTC_MIR_SET0		0x008c
 #define INTC_PENDING_IRQ0	0x0098
+#define INTC_ILR0		0x0100
 /* Number of IRQ state bits in each MIR register */
 #define IRQ_BITS_PER_REG	32
 
@@ -40,6 +45,12 @@
 #define OMAP3_IRQ_BASE		OMAP2_L4_IO_ADDRESS(OMAP34XX_IC_BASE)
 #define INTCPS_SIR_IRQ_OFFSET	0x0040	/* omap2/3 active interrupt offset */
 #define ACTIVEIRQ_MASK		0x7f	/* omap2/3 active interrupt bits */
+#define SPURIOUSIRQ_MASK	(~ACTIVEIRQ_MASK) /* SIR spurious flag bits */
+
+/* ILRm: 0 is the highest priority, 63 the lowest */
+#define ILR_PRIORITY_SHIFT	2
+#define ILR_PRIORITY_MASK	(0x3f << ILR_PRIORITY_SHIFT)
+#define INTC_MAX_PRIORITY	63
 
 /*
  * OMAP2 has a number of different interrupt controllers, each interrupt
@@ -203,30 +214,234 @@ void __init ti81xx_init_irq(void)
 	omap_init_irq(OMAP34XX_IC_BASE, 128);
 }
 
+/**
+ * omap_intc_set_priority - set the INTC priority of an interrupt
+ * @irq: interrupt number on the MPU INTC
+ * @priority: 0 (highest) to 63 (lowest)
+ *
+ * When several interrupts are pending at once, the INTC presents the one
+ * with the highest priority in SIR first and the dispatcher handles them
+ * in that order.  All interrupts default to priority 0, in which case the
+ * lowest numbered one wins.
+ */
+int omap_intc_set_priority(unsigned int irq, unsigned int priority)
+{
+	struct omap_irq_bank *bank = &irq_banks[0];
+	unsigned long flags;
+	u32 ilr;
+
+	if (irq >= bank->nr_irqs || priority > INTC_MAX_PRIORITY)
+		return -EINVAL;
+
+	local_irq_save(flags);
+	ilr = intc_bank_read_reg(bank, INTC_ILR0 + 0x4 * irq);
+	ilr &= ~ILR_PRIORITY_MASK;
+	ilr |= priority << ILR_PRIORITY_SHIFT;
+	intc_bank_write_reg(ilr, bank, INTC_ILR0 + 0x4 * irq);
+	local_irq_restore(flags);
+
+	return 0;
+}
+
+#ifdef CONFIG_DEBUG_FS
+/*
+ * Per-IRQ dispatch latency, enabled at run time through debugfs.
+ *
+ * The INTC does not timestamp assertions, so the latency is measured from
+ * the IRQ exception entry to the call of the flow handler.  It therefore
+ * covers the time an interrupt spent waiting behind higher priority ones
+ * handled in the same entry, but not the time the CPU had interrupts
+ * masked before taking the exception.
+ */
+#define INTC_LAT_BUCKETS	10	/* < 1, 2, 4 ... 256 us, >= 256 us */
+
+struct intc_irq_stats {
+	u32	count;
+	u32	max_ns;
+	u32	hist[INTC_LAT_BUCKETS];
+};
+
+static struct intc_irq_stats intc_stats[INTCPS_MAX_NR_IRQS];
+static u32 intc_stats_enabled;
+
+static void intc_stats_account(u32 irqnr, unsigned long long entry)
+{
+	struct intc_irq_stats *st = &intc_stats[irqnr];
+	u32 ns = min_t(unsigned long long, sched_clock() - entry, UINT_MAX);
+
+	st->count++;
+	if (ns > st->max_ns)
+		st->max_ns = ns;
+	st->hist[min(fls(ns / NSEC_PER_USEC), INTC_LAT_BUCKETS - 1)]++;
+}
+
+static int intc_latency_show(struct seq_file *s, void *unused)
+{
+	int irq, i;
+
+	seq_puts(s, "irq      count   max(ns)      <1us");
+	for (i = 1; i < INTC_LAT_BUCKETS - 1; i++)
+		seq_printf(s, " %7dus", 1 << i);
+	seq_printf(s, " >=%5dus\n", 1 << (INTC_LAT_BUCKETS - 2));
+
+	for (irq = 0; irq < irq_banks[0].nr_irqs; irq++) {
+		struct intc_irq_stats *st = &intc_stats[irq];
+
+		if (!st->count)
+			continue;
+		seq_printf(s, "%3d %10u %9u", irq, st->count, st->max_ns);
+		for (i = 0; i < INTC_LAT_BUCKETS; i++)
+			seq_printf(s, " %9u", st->hist[i]);
+		seq_putc(s, '\n');
+	}
+	return 0;
+}
+
+static int intc_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, intc_latency_show, inode->i_private);
+}
+
+static ssize_t intc_latency_write(struct file *file, const char __user *buf,
+				  size_t count, loff_t *ppos)
+{
+	unsigned long flags;
+
+	/* Any write clears the statistics */
+	local_irq_save(flags);
+	memset(intc_stats, 0, sizeof(intc_stats));
+	local_irq_restore(flags);
+
+	return count;
+}
+
+static const struct file_operations intc_latency_fops = {
+	.open		= intc_latency_open,
+	.read		= seq_read,
+	.write		= intc_latency_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int intc_priority_show(struct seq_file *s, void *unused)
+{
+	struct omap_irq_bank *bank = &irq_banks[0];
+	int irq;
+	u32 ilr;
+
+	for (irq = 0; irq < bank->nr_irqs; irq++) {
+		ilr = intc_bank_read_reg(bank, INTC_ILR0 + 0x4 * irq);
+		if (ilr & ILR_PRIORITY_MASK)
+			seq_printf(s, "%d %u\n", irq,
+				   (ilr & ILR_PRIORITY_MASK) >> ILR_PRIORITY_SHIFT);
+	}
+	return 0;
+}
+
+static int intc_priority_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, intc_priority_show, inode->i_private);
+}
+
+/* Takes "<irq> <priority>" */
+static ssize_t intc_priority_write(struct file *file, const char __user *buf,
+				   size_t count, loff_t *ppos)
+{
+	unsigned int irq, priority;
+	char kbuf[16];
+	int ret;
+
+	if (count >= sizeof(kbuf))
+		return -EINVAL;
+	if (copy_from_user(kbuf, buf, count))
+		return -EFAULT;
+	kbuf[count] = '\0';
+
+	if (sscanf(kbuf, "%u %u", &irq, &priority) != 2)
+		return -EINVAL;
+
+	ret = omap_intc_set_priority(irq, priority);
+	return ret ? ret : count;
+}
+
+static const struct file_operations intc_priority_fops = {
+	.open		= intc_priority_open,
+	.read		= seq_read,
+	.write		= intc_priority_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init omap_intc_debugfs_init(void)
+{
+	struct dentry *d;
+
+	if (!irq_banks[0].base_reg)
+		return 0;
+
+	d = debugfs_create_dir("omap_intc", NULL);
+	if (!d)
+		return -ENOMEM;
+
+	debugfs_create_bool("latency_enable", S_IRUGO | S_IWUSR, d,
+			    &intc_stats_enabled);
+	debugfs_create_file("latency", S_IRUGO | S_IWUSR, d, NULL,
+			    &intc_latency_fops);
+	debugfs_create_file("priority", S_IRUGO | S_IWUSR, d, NULL,
+			    &intc_priority_fops);
+	return 0;
+}
+late_initcall(omap_intc_debugfs_init);
+#else
+#define intc_stats_enabled		0
+static inline void intc_stats_account(u32 irqnr, unsigned long long entry) { }
+#endif /* CONFIG_DEBUG_FS */
+
+/*
+ * Handle every interrupt pending at entry in one pass.  The pending
+ * registers are read once; after that SIR alone says which source to
+ * handle next, in priority order, since the flow handler's ack (NEWIRQAGR)
+ * makes the INTC sort the remaining ones again.  A source asserting while
+ * we are here is handled as well if SIR presents it.  SIR showing a source
+ * already handled in this pass means the INTC has nothing newer to offer,
+ * so we leave and let the exception re-enter if needed.
+ */
 static inline void omap_intc_handle_irq(void __iomem *base_addr,
 		unsigned int no_regs_req, struct pt_regs *regs)
 {
-	u32 irqnr = 0;
+	u32 pending[INTCPS_MAX_NR_REGS_REQ];
+	u32 handled[INTCPS_MAX_NR_REGS_REQ] = { 0 };
+	unsigned long long entry = 0;
+	u32 left = 0, irqnr, bit;
+	int i;
 
-	do {
-		int i = 0;
+	if (unlikely(intc_stats_enabled))
+		entry = sched_clock();
 
-		for (i = 0; i < no_regs_req; i++) {
-			irqnr = readl_relaxed(base_addr + 0x98 + (0x20 * i));
-			if (irqnr)
-				goto out;
-		}
+	for (i = 0; i < no_regs_req; i++) {
+		pending[i] = readl_relaxed(base_addr + INTC_PENDING_IRQ0 +
+					   (0x20 * i));
+		left |= pending[i];
+	}
 
-out:
-		if (!irqnr)
+	while (left) {
+		irqnr = readl_relaxed(base_addr + INTCPS_SIR_IRQ_OFFSET);
+		if (irqnr & SPURIOUSIRQ_MASK)
 			break;
 
-		irqnr = readl_relaxed(base_addr + INTCPS_SIR_IRQ_OFFSET);
-		irqnr &= ACTIVEIRQ_MASK;
+		bit = 1 << (irqnr & 0x1f);
+		if (handled[irqnr >> 5] & bit)
+			break;
+		handled[irqnr >> 5] |= bit;
+
+		if (unlikely(intc_stats_enabled))
+			intc_stats_account(irqnr, entry);
 
-		if (irqnr)
-			handle_IRQ(irqnr, regs);
-	} while (irqnr);
+		handle_IRQ(irqnr, regs);
+
+		for (left = 0, i = 0; i < no_regs_req; i++)
+			left |= pending[i] & ~handled[i];
+	}
 }
 
 asmlinkage void __exception_irq_entry omap2_intc_handle_irq(struct pt_regs *regs)
@@ -166,6 +166,7 @@ static struct omap_opp_def __initdata omap36xx_opp_def_list[] = {
 #define AM33XX_VDD_MPU_OPP100_UV	1100000
 #define AM33XX_VDD_MPU_OPP120_UV	1200000
 #define AM33XX_VDD_MPU_OPPTURBO_UV	1260000
+#define AM33XX_VDD_MPU_OPPNITRO_UV	1325000
 
 static struct omap_opp_def __initdata am33xx_opp_def_list[] = {
 	/* MPU OPP1 - OPP50 */
@@ -176,6 +177,12 @@ static struct omap_opp_def __initdata am33xx_opp_def_list[] = {
 	OPP_INITIALIZER("mpu", true,  600000000, AM33XX_VDD_MPU_OPP120_UV),
 	/* MPU OPP4 - OPPTurbo */
 	OPP_INITIALIZER("mpu", true,  720000000, AM33XX_VDD_MPU_OPPTURBO_UV),
+	/*
+	 * MPU OPP5 - OPPNitro, only for devices rated for 1 GHz: boards
+	 * with such parts and enough supply current enable it with
+	 * opp_enable().
+	 */
+	OPP_INITIALIZER("mpu", false, 1000000000, AM33XX_VDD_MPU_OPPNITRO_UV),
 };
 
 /**
@@ -474,10 +474,16 @@ do_translation_fault(unsigned long addr, unsigned int fsr,
 /*
  * Some section permission faults need to be handled gracefully.
  * They can happen due to a __{get,put}_user during an oops.
+ * Huge pages are mapped with sections, so in user space these are
+ * the write faults used for copy on write.
  */
 static int
 do_sect_fault(unsigned long addr, unsigned int fsr, struct pt_regs *regs)
 {
+#ifdef CONFIG_HUGETLB_PAGE
+	if (addr < TASK_SIZE)
+		return do_page_fault(addr, fsr, regs);
+#endif
 	do_bad_area(addr, fsr, regs);
 	return 0;
 }
@@ -0,0 +1,244 @@
+/*
+ *  arch/arm/mm/hugetlbpage.c
+ *
+ * ARM HugeTLB page support for the classic two level page tables.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * A 2MiB huge page is mapped by the two 1MiB sections making up one
+ * Linux PMD, so a TLB entry covers 256 times the memory a small page
+ * entry does and a miss is resolved by a single level walk.
+ *
+ * Sections carry no Linux state bits.  The huge pte format seen by the
+ * generic code is the Linux PTE one, and it is converted on the way in
+ * and out of the page table:
+ *
+ *  - "young" is not tracked: hugetlb pages are never on the LRU, so a
+ *    present huge pte always reads back as young.
+ *  - "dirty" is not tracked either: a writable huge page is mapped
+ *    writable and reads back as dirty.  hugetlbfs pages have no backing
+ *    store to be written to, they are dirty as soon as they are mapped.
+ *  - a non-present huge pte, i.e. a migration or hwpoison entry, has
+ *    bits [1:0] clear and is stored unmodified, as a fault entry.
+ *
+ * The memory type bits map one to one with TEX remapping, which is
+ * always enabled on ARMv7: TEX[0], C and B index the same PRRR/NMRR
+ * entry for sections as they do for small pages.
+ */
+#include <linux/init.h>
+#include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/hugetlb.h>
+#include <linux/pagemap.h>
+
+#include <asm/cacheflush.h>
+#include <asm/cachetype.h>
+#include <asm/domain.h>
+#include <asm/pgalloc.h>
+#include <asm/tlbflush.h>
+
+#include "mm.h"
+
+#define HUGE_SECT_MT		(PMD_SECT_BUFFERABLE | PMD_SECT_CACHEABLE)
+
+static pmdval_t huge_pte_to_sect(pte_t pte)
+{
+	pteval_t val = pte_val(pte);
+	pmdval_t sect;
+
+	if (!(val & L_PTE_PRESENT))
+		return val;
+
+	sect = (val & HPAGE_MASK) | PMD_TYPE_SECT | PMD_DOMAIN(DOMAIN_USER) |
+		(val & HUGE_SECT_MT) | PMD_SECT_AP_WRITE;
+	if (val & (1 << 4))		/* TEX[0] of L_PTE_MT_xxx */
+		sect |= PMD_SECT_TEX(1);
+	if (val & L_PTE_RDONLY)
+		sect |= PMD_SECT_APX;
+	if (val & L_PTE_USER) {
+		sect |= PMD_SECT_AP_READ | PMD_SECT_nG;
+#ifdef CONFIG_CPU_USE_DOMAINS
+		/* allow kernel read/write access to read-only user pages */
+		if (sect & PMD_SECT_APX)
+			sect &= ~(PMD_SECT_APX | PMD_SECT_AP_WRITE);
+#endif
+	}
+	if (val & L_PTE_XN)
+		sect |= PMD_SECT_XN;
+	if (val & L_PTE_SHARED)
+		sect |= PMD_SECT_S;
+
+	return sect;
+}
+
+static pte_t huge_sect_to_pte(pmdval_t sect)
+{
+	pteval_t val;
+
+	if ((sect & PMD_TYPE_MASK) != PMD_TYPE_SECT)
+		return __pte(sect);
+
+	val = (sect & HPAGE_MASK) | L_PTE_PRESENT | L_PTE_YOUNG |
+		(sect & HUGE_SECT_MT);
+	if (sect & PMD_SECT_TEX(1))
+		val |= 1 << 4;
+	if (sect & PMD_SECT_AP_READ)
+		val |= L_PTE_USER;
+	if ((sect & PMD_SECT_APX) ||
+	    ((sect & PMD_SECT_AP_READ) && !(sect & PMD_SECT_AP_WRITE)))
+		val |= L_PTE_RDONLY;
+	else
+		val |= L_PTE_DIRTY;
+	if (sect & PMD_SECT_XN)
+		val |= L_PTE_XN;
+	if (sect & PMD_SECT_S)
+		val |= L_PTE_SHARED;
+
+	return __pte(val);
+}
+
+/*
+ * The huge page equivalent of __sync_icache_dcache().  Pages of the
+ * hugetlb pool are reused without passing through the page allocator,
+ * so PG_dcache_clean cannot be trusted for executable mappings: write
+ * the data cache back for the whole page before it may be executed.
+ */
+static void huge_sync_icache_dcache(pte_t pte)
+{
+	struct address_space *mapping = NULL;
+	struct page *page;
+	int i;
+
+	if (cache_is_vipt_nonaliasing() && !pte_exec(pte))
+		return;
+
+	page = pte_page(pte);
+	if (cache_is_vipt_aliasing())
+		mapping = page_mapping(page);
+
+	for (i = 0; i < HPAGE_SIZE / PAGE_SIZE; i++)
+		if (!test_and_set_bit(PG_dcache_clean, &page[i].flags) ||
+		    pte_exec(pte))
+			__flush_dcache_page(mapping, page + i);
+
+	if (pte_exec(pte))
+		__flush_icache_all();
+}
+
+static void huge_pmd_set(pmd_t *pmdp, pmdval_t sect)
+{
+	pmdp[0] = __pmd(sect);
+	pmdp[1] = __pmd((sect & PMD_TYPE_MASK) == PMD_TYPE_SECT ?
+			sect + SECTION_SIZE : sect);
+	flush_pmd_entry(pmdp);
+}
+
+static void huge_flush_tlb(struct vm_area_struct *vma, unsigned long addr)
+{
+	addr &= HPAGE_MASK;
+	flush_tlb_page(vma, addr);
+	flush_tlb_page(vma, addr + SECTION_SIZE);
+}
+
+void set_huge_pte_at(struct mm_struct *mm, unsigned long addr,
+		     pte_t *ptep, pte_t pte)
+{
+	if (addr < TASK_SIZE && pte_present_user(pte))
+		huge_sync_icache_dcache(pte);
+
+	huge_pmd_set((pmd_t *)ptep, huge_pte_to_sect(pte));
+}
+
+pte_t huge_ptep_get(pte_t *ptep)
+{
+	return huge_sect_to_pte(pmd_val(*(pmd_t *)ptep));
+}
+
+pte_t huge_ptep_get_and_clear(struct mm_struct *mm, unsigned long addr,
+			      pte_t *ptep)
+{
+	pmd_t *pmdp = (pmd_t *)ptep;
+	pte_t pte = huge_ptep_get(ptep);
+
+	pmd_clear(pmdp);
+	return pte;
+}
+
+void huge_ptep_clear_flush(struct vm_area_struct *vma, unsigned long addr,
+			   pte_t *ptep)
+{
+	pmd_t *pmdp = (pmd_t *)ptep;
+
+	pmd_clear(pmdp);
+	huge_flush_tlb(vma, addr);
+}
+
+int huge_ptep_set_access_flags(struct vm_area_struct *vma,
+			       unsigned long addr, pte_t *ptep,
+			       pte_t pte, int dirty)
+{
+	if (pte_same(huge_ptep_get(ptep), pte))
+		return 0;
+
+	set_huge_pte_at(vma->vm_mm, addr, ptep, pte);
+	huge_flush_tlb(vma, addr);
+	return 1;
+}
+
+/*
+ * The PMD is folded into the pgd, so the "huge pte" is the pgd slot
+ * itself and there is nothing to allocate.
+ */
+pte_t *huge_pte_alloc(struct mm_struct *mm, unsigned long addr,
+		      unsigned long sz)
+{
+	pgd_t *pgd = pgd_offset(mm, addr);
+	pud_t *pud = pud_offset(pgd, addr);
+	pmd_t *pmd = pmd_offset(pud, addr);
+
+	/* A page table left over from small page mappings */
+	if (WARN_ON_ONCE(pmd_val(*pmd) & PMD_TYPE_TABLE))
+		return NULL;
+	return (pte_t *)pmd;
+}
+
+pte_t *huge_pte_offset(struct mm_struct *mm, unsigned long addr)
+{
+	pgd_t *pgd = pgd_offset(mm, addr);
+	pud_t *pud = pud_offset(pgd, addr);
+
+	return (pte_t *)pmd_offset(pud, addr);
+}
+
+int huge_pmd_unshare(struct mm_struct *mm, unsigned long *addr, pte_t *ptep)
+{
+	return 0;
+}
+
+struct page *follow_huge_addr(struct mm_struct *mm, unsigned long address,
+			      int write)
+{
+	return ERR_PTR(-EINVAL);
+}
+
+int pmd_huge(pmd_t pmd)
+{
+	return pmd_val(pmd) && !(pmd_val(pmd) & PMD_TYPE_TABLE);
+}
+
+int pud_huge(pud_t pud)
+{
+	return 0;
+}
+
+struct page *follow_huge_pmd(struct mm_struct *mm, unsigned long address,
+			     pmd_t *pmd, int write)
+{
+	pte_t pte = huge_ptep_get((pte_t *)pmd);
+
+	if (!pte_present(pte))
+		return NULL;
+	return pte_page(pte) + ((address & ~HPAGE_MASK) >> PAGE_SHIFT);
+}
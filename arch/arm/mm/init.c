@@ -20,6 +20,7 @@
 #include <linux/highmem.h>
 #include <linux/gfp.h>
 #include <linux/memblock.h>
+#include <linux/dma-contiguous.h>
 
 #include <asm/mach-types.h>
 #include <asm/prom.h>
@@ -308,6 +309,7 @@ static void arm_memory_present(void)
 
 void __init arm_memblock_init(struct meminfo *mi, struct machine_desc *mdesc)
 {
+	phys_addr_t cma_limit;
 	int i;
 
 	memblock_init();
@@ -349,6 +351,19 @@ void __init arm_memblock_init(struct meminfo *mi, struct machine_desc *mdesc)
 	if (mdesc->reserve)
 		mdesc->reserve();
 
+	/*
+	 * Reserve the contiguous DMA area below the lowmem limit, and
+	 * within the DMA zone if the machine has one: buffers handed out
+	 * from it are addressed through the kernel linear map.
+	 */
+	cma_limit = __pa(high_memory - 1) + 1;
+#ifdef CONFIG_ZONE_DMA
+	if (mdesc->dma_zone_size)
+		cma_limit = min_t(phys_addr_t, cma_limit,
+				  PHYS_OFFSET + mdesc->dma_zone_size);
+#endif
+	dma_contiguous_reserve(cma_limit);
+
 	memblock_analyze();
 	memblock_dump_all();
 }
@@ -209,23 +209,26 @@ static int __init omap_i2c_add_bus(int bus_id)
  * @str: String of options
  *
  * This function allow to override the default I2C bus speed for given I2C
- * bus with a command line option.
+ * bus with a command line option, and optionally the SCHED_FIFO priority
+ * of its interrupt thread.
  *
- * Format: i2c_bus=bus_id,clkrate (in kHz)
+ * Format: i2c_bus=bus_id,clkrate (in kHz)[,irq_thread_prio]
  *
  * Returns 1 on success, 0 otherwise.
  */
 static int __init omap_i2c_bus_setup(char *str)
 {
 	int ports;
-	int ints[3];
+	int ints[4];
 
 	ports = omap_i2c_nr_ports();
-	get_options(str, 3, ints);
+	get_options(str, 4, ints);
 	if (ints[0] < 2 || ints[1] < 1 || ints[1] > ports)
 		return 0;
 	i2c_pdata[ints[1] - 1].clkrate = ints[2];
 	i2c_pdata[ints[1] - 1].clkrate |= OMAP_I2C_CMDLINE_SETUP;
+	if (ints[0] > 2 && ints[3] > 0)
+		i2c_pdata[ints[1] - 1].irq_thread_prio = ints[3];
 
 	return 1;
 }
@@ -18,6 +18,9 @@
 
 extern struct gen_pool *omap_gen_pool;
 
+extern void *omap_sram_alloc(size_t len, dma_addr_t *dma);
+extern void omap_sram_free(void *addr, size_t len);
+
 /*
  * Note that fncpy requires the SRAM address to be aligned to an 8-byte
  * boundary, so the min_alloc_order for the pool is set appropriately.
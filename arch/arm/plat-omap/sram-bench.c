@@ -0,0 +1,169 @@
+/*
+ * linux/arch/arm/plat-omap/sram-bench.c
+ *
+ * On-chip SRAM vs DDR access benchmark
+ *
+ * Runs the access patterns of the buffers that are candidates for SRAM
+ * against a buffer from omap_sram_alloc() and one from
+ * dma_alloc_coherent(), which is what those drivers use today:
+ *
+ *  desc:   write a 16 byte DMA descriptor, then read back its status
+ *          word (CPDMA/EDMA descriptor ring handling by the CPU)
+ *  chase:  dependent 32-bit loads at random offsets (load latency)
+ *  fill:   memcpy of one audio period into the buffer (ping-pong fill)
+ *  drain:  memcpy of one audio period out of the buffer
+ *
+ * Results are printed to the kernel log when the module is loaded.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/slab.h>
+#include <linux/random.h>
+#include <linux/hrtimer.h>
+#include <linux/dma-mapping.h>
+
+#include <plat/sram.h>
+
+static unsigned int buf_kb = 8;
+module_param(buf_kb, uint, 0444);
+MODULE_PARM_DESC(buf_kb, "Buffer size in KiB (default 8)");
+
+static unsigned int loops = 100;
+module_param(loops, uint, 0444);
+MODULE_PARM_DESC(loops, "Passes over the buffer per test");
+
+struct bench_desc {
+	u32	next;
+	u32	buf;
+	u32	len;
+	u32	status;
+};
+
+static s64 bench_desc(void *mem, size_t size)
+{
+	volatile struct bench_desc *d = mem;
+	unsigned int n = size / sizeof(*d), i, l;
+	ktime_t start = ktime_get();
+	u32 sum = 0;
+
+	for (l = 0; l < loops; l++) {
+		for (i = 0; i < n; i++) {
+			d[i].next = i + 1;
+			d[i].buf = i;
+			d[i].len = 64;
+			d[i].status = l;
+			sum += d[i].status;
+		}
+	}
+	(void)sum;
+	return div_s64(ktime_to_ns(ktime_sub(ktime_get(), start)), loops * n);
+}
+
+static s64 bench_chase(void *mem, size_t size)
+{
+	volatile u32 *p = mem;
+	unsigned int n = size / sizeof(u32), i, l, j;
+	ktime_t start;
+	u32 idx = 0;
+
+	/* Sattolo's shuffle: a single cycle through every slot */
+	for (i = 0; i < n; i++)
+		p[i] = i;
+	for (i = n - 1; i > 0; i--) {
+		u32 tmp;
+
+		j = random32() % i;
+		tmp = p[i];
+		p[i] = p[j];
+		p[j] = tmp;
+	}
+
+	start = ktime_get();
+	for (l = 0; l < loops; l++)
+		for (i = 0; i < n; i++)
+			idx = p[idx];
+	(void)idx;
+	return div_s64(ktime_to_ns(ktime_sub(ktime_get(), start)), loops * n);
+}
+
+static s64 bench_copy(void *mem, void *ddr, size_t size, bool fill)
+{
+	ktime_t start = ktime_get();
+	unsigned int l;
+	s64 ns;
+
+	for (l = 0; l < loops; l++) {
+		if (fill)
+			memcpy(mem, ddr, size);
+		else
+			memcpy(ddr, mem, size);
+	}
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	/* MB/s */
+	return ns ? div64_s64((s64)size * loops * 1000, ns) : 0;
+}
+
+static void bench_run(const char *name, void *mem, void *ddr, size_t size)
+{
+	pr_info("sram bench: %-6s desc %lld ns, chase %lld ns, "
+		"fill %lld MB/s, drain %lld MB/s\n", name,
+		bench_desc(mem, size), bench_chase(mem, size),
+		bench_copy(mem, ddr, size, true),
+		bench_copy(mem, ddr, size, false));
+}
+
+static int __init sram_bench_init(void)
+{
+	size_t size = buf_kb * 1024;
+	void *sram, *coherent, *cached;
+	dma_addr_t sram_dma, dma;
+
+	if (!size || !loops)
+		return -EINVAL;
+
+	cached = kmalloc(size, GFP_KERNEL);
+	if (!cached)
+		return -ENOMEM;
+	memset(cached, 0x5a, size);
+
+	sram = omap_sram_alloc(size, &sram_dma);
+	if (!sram) {
+		pr_err("sram bench: cannot allocate %zu bytes of SRAM (%zu "
+		       "free)\n", size, gen_pool_avail(omap_gen_pool));
+		kfree(cached);
+		return -ENOMEM;
+	}
+
+	coherent = dma_alloc_coherent(NULL, size, &dma, GFP_KERNEL);
+	if (!coherent) {
+		omap_sram_free(sram, size);
+		kfree(cached);
+		return -ENOMEM;
+	}
+
+	pr_info("sram bench: %zu byte buffers, %u loops, SRAM at %#x\n",
+		size, loops, (u32)sram_dma);
+
+	bench_run("sram", sram, cached, size);
+	bench_run("ddr", coherent, cached, size);
+
+	dma_free_coherent(NULL, size, coherent, dma);
+	omap_sram_free(sram, size);
+	kfree(cached);
+	return 0;
+}
+
+static void __exit sram_bench_exit(void)
+{
+}
+
+module_init(sram_bench_init);
+module_exit(sram_bench_exit);
+MODULE_DESCRIPTION("OMAP on-chip SRAM vs DDR access benchmark");
+MODULE_LICENSE("GPL v2");
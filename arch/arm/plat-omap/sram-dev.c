@@ -0,0 +1,188 @@
+/*
+ * linux/arch/arm/plat-omap/sram-dev.c
+ *
+ * Character device giving user space buffers in OMAP on-chip SRAM
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/miscdevice.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+#include <linux/omap-sram.h>
+
+#include <plat/sram.h>
+
+struct sram_buf {
+	struct kref	ref;
+	void		*alloc;		/* as returned by omap_sram_alloc() */
+	size_t		alloc_len;
+	void		*vaddr;		/* page aligned start of the buffer */
+	dma_addr_t	phys;
+	size_t		len;
+};
+
+static DEFINE_MUTEX(sram_dev_lock);
+
+static void sram_buf_release(struct kref *ref)
+{
+	struct sram_buf *buf = container_of(ref, struct sram_buf, ref);
+
+	omap_sram_free(buf->alloc, buf->alloc_len);
+	kfree(buf);
+}
+
+/*
+ * The pool only guarantees 8-byte alignment, so over-allocate by a page
+ * and map from the first page boundary.  The pool's base is page aligned,
+ * so the physical address is aligned as well.
+ */
+static struct sram_buf *sram_buf_alloc(size_t size)
+{
+	struct sram_buf *buf;
+	dma_addr_t dma;
+
+	buf = kzalloc(sizeof(*buf), GFP_KERNEL);
+	if (!buf)
+		return NULL;
+
+	buf->len = PAGE_ALIGN(size);
+	buf->alloc_len = buf->len + PAGE_SIZE;
+	buf->alloc = omap_sram_alloc(buf->alloc_len, &dma);
+	if (!buf->alloc) {
+		kfree(buf);
+		return NULL;
+	}
+
+	buf->vaddr = PTR_ALIGN(buf->alloc, PAGE_SIZE);
+	buf->phys = dma + (buf->vaddr - buf->alloc);
+	memset(buf->vaddr, 0, buf->len);
+	kref_init(&buf->ref);
+	return buf;
+}
+
+static int sram_dev_open(struct inode *inode, struct file *file)
+{
+	file->private_data = NULL;
+	return nonseekable_open(inode, file);
+}
+
+static int sram_dev_release(struct inode *inode, struct file *file)
+{
+	struct sram_buf *buf = file->private_data;
+
+	if (buf)
+		kref_put(&buf->ref, sram_buf_release);
+	return 0;
+}
+
+static long sram_dev_ioctl(struct file *file, unsigned int cmd,
+			   unsigned long arg)
+{
+	struct omap_sram_req req;
+	struct sram_buf *buf;
+
+	if (cmd != OMAP_SRAM_IOC_ALLOC)
+		return -ENOTTY;
+
+	if (copy_from_user(&req, (void __user *)arg, sizeof(req)))
+		return -EFAULT;
+	if (!req.size)
+		return -EINVAL;
+
+	mutex_lock(&sram_dev_lock);
+	if (file->private_data) {
+		mutex_unlock(&sram_dev_lock);
+		return -EBUSY;
+	}
+	buf = sram_buf_alloc(req.size);
+	file->private_data = buf;
+	mutex_unlock(&sram_dev_lock);
+
+	if (!buf)
+		return -ENOMEM;
+
+	req.size = buf->len;
+	req.phys = buf->phys;
+	if (copy_to_user((void __user *)arg, &req, sizeof(req)))
+		return -EFAULT;
+	return 0;
+}
+
+static void sram_vma_open(struct vm_area_struct *vma)
+{
+	struct sram_buf *buf = vma->vm_private_data;
+
+	kref_get(&buf->ref);
+}
+
+static void sram_vma_close(struct vm_area_struct *vma)
+{
+	struct sram_buf *buf = vma->vm_private_data;
+
+	kref_put(&buf->ref, sram_buf_release);
+}
+
+static const struct vm_operations_struct sram_vm_ops = {
+	.open	= sram_vma_open,
+	.close	= sram_vma_close,
+};
+
+static int sram_dev_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct sram_buf *buf = file->private_data;
+	unsigned long size = vma->vm_end - vma->vm_start;
+	int ret;
+
+	if (!buf)
+		return -EINVAL;
+	if (vma->vm_pgoff || size > buf->len)
+		return -EINVAL;
+
+	/* Same memory type as the kernel's uncached SRAM mapping */
+	vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
+	vma->vm_flags |= VM_IO | VM_RESERVED;
+
+	ret = remap_pfn_range(vma, vma->vm_start, buf->phys >> PAGE_SHIFT,
+			      size, vma->vm_page_prot);
+	if (ret)
+		return ret;
+
+	vma->vm_private_data = buf;
+	vma->vm_ops = &sram_vm_ops;
+	sram_vma_open(vma);
+	return 0;
+}
+
+static const struct file_operations sram_dev_fops = {
+	.owner		= THIS_MODULE,
+	.open		= sram_dev_open,
+	.release	= sram_dev_release,
+	.unlocked_ioctl	= sram_dev_ioctl,
+	.mmap		= sram_dev_mmap,
+	.llseek		= no_llseek,
+};
+
+static struct miscdevice sram_miscdev = {
+	.minor	= MISC_DYNAMIC_MINOR,
+	.name	= "omap-sram",
+	.fops	= &sram_dev_fops,
+};
+
+static int __init sram_dev_init(void)
+{
+	if (!omap_gen_pool)
+		return -ENODEV;
+
+	pr_info("SRAM: %zu of %zu bytes free for allocation\n",
+		gen_pool_avail(omap_gen_pool), gen_pool_size(omap_gen_pool));
+	return misc_register(&sram_miscdev);
+}
+late_initcall(sram_dev_init);
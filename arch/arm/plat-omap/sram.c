@@ -100,6 +100,46 @@ static int is_sram_locked(void)
 struct gen_pool *omap_gen_pool;
 EXPORT_SYMBOL_GPL(omap_gen_pool);
 
+/**
+ * omap_sram_alloc - allocate a data buffer in on-chip SRAM
+ * @len: number of bytes
+ * @dma: set to the physical (bus) address of the buffer
+ *
+ * SRAM is mapped uncached on OMAP3 and AM33xx, so the buffer can be
+ * shared with DMA masters and the PRUSS without cache maintenance.  The
+ * pool is shared with the code pushed by omap_sram_push(), which is
+ * allocated at boot and never freed.
+ *
+ * Returns the kernel virtual address, or NULL if the pool is exhausted.
+ */
+void *omap_sram_alloc(size_t len, dma_addr_t *dma)
+{
+	unsigned long vaddr;
+
+	if (!omap_gen_pool)
+		return NULL;
+
+	vaddr = gen_pool_alloc(omap_gen_pool, len);
+	if (!vaddr)
+		return NULL;
+
+	if (dma)
+		*dma = gen_pool_virt_to_phys(omap_gen_pool, vaddr);
+	return (void *)vaddr;
+}
+EXPORT_SYMBOL_GPL(omap_sram_alloc);
+
+/**
+ * omap_sram_free - free a buffer allocated with omap_sram_alloc()
+ * @addr: kernel virtual address returned by omap_sram_alloc()
+ * @len: size passed to omap_sram_alloc()
+ */
+void omap_sram_free(void *addr, size_t len)
+{
+	gen_pool_free(omap_gen_pool, (unsigned long)addr, len);
+}
+EXPORT_SYMBOL_GPL(omap_sram_free);
+
 /*
  * The amount of SRAM depends on the core type.
  * Note that we cannot try to test for SRAM here because writes
@@ -23,6 +23,7 @@
 #include <linux/clk.h>
 #include <linux/io.h>
 #include <linux/opp.h>
+#include <linux/rcupdate.h>
 #include <linux/cpu.h>
 #include <linux/module.h>
 #include <linux/regulator/consumer.h>
@@ -48,6 +49,14 @@
 /* Use 275MHz when entering suspend */
 #define SLEEP_FREQ	(275 * 1000)
 
+/*
+ * Transition latencies in ns: the DPLL relock plus PMIC access, on top
+ * of which comes the regulator ramp time, and the value used when the
+ * regulator cannot tell its ramp time.
+ */
+#define MPU_RELOCK_LATENCY		(100 * 1000)
+#define MPU_DEFAULT_TRANSITION_LATENCY	(300 * 1000)
+
 
 #ifdef CONFIG_SMP
 struct lpj_info {
@@ -234,6 +243,51 @@ static int omap_target(struct cpufreq_policy *policy,
 	return ret;
 }
 
+/* Lowest voltage the MPU regulator will actually settle at for @uV */
+static int omap_mpu_reg_voltage(int uV)
+{
+	int i, v, best = INT_MAX;
+
+	for (i = 0; i < regulator_count_voltages(mpu_reg); i++) {
+		v = regulator_list_voltage(mpu_reg, i);
+		if (v >= uV && v < best)
+			best = v;
+	}
+	return best == INT_MAX ? -EINVAL : best;
+}
+
+/*
+ * Worst case transition: ramping between the lowest and the highest OPP
+ * voltage, plus the DPLL relock.  The ondemand governor derives its
+ * sampling rate from this, so overestimating it slows down ramp up.
+ */
+static unsigned int omap_transition_latency(void)
+{
+	unsigned long freq = 0;
+	int volt, volt_min = INT_MAX, volt_max = 0, ramp;
+	struct opp *opp;
+
+	rcu_read_lock();
+	while (!IS_ERR(opp = opp_find_freq_ceil(mpu_dev, &freq))) {
+		volt = opp_get_voltage(opp);
+		volt_min = min(volt_min, volt);
+		volt_max = max(volt_max, volt);
+		freq++;
+	}
+	rcu_read_unlock();
+
+	if (!volt_max)
+		return MPU_DEFAULT_TRANSITION_LATENCY;
+
+	ramp = regulator_set_voltage_time(mpu_reg,
+					  omap_mpu_reg_voltage(volt_min),
+					  omap_mpu_reg_voltage(volt_max));
+	if (ramp < 0)
+		return MPU_DEFAULT_TRANSITION_LATENCY;
+
+	return ramp * 1000 + MPU_RELOCK_LATENCY;
+}
+
 static inline void freq_table_free(void)
 {
 	if (atomic_dec_and_test(&freq_table_users))
@@ -339,8 +393,9 @@ static int __cpuinit omap_cpu_init(struct cpufreq_policy *policy)
 		cpumask_setall(policy->cpus);
 	}
 
-	/* FIXME: what's the actual transition time? */
-	policy->cpuinfo.transition_latency = 300 * 1000;
+	policy->cpuinfo.transition_latency = omap_transition_latency();
+	dev_dbg(mpu_dev, "transition latency %u ns\n",
+		policy->cpuinfo.transition_latency);
 
 	register_pm_notifier(&omap_cpu_pm_notifier);
 
@@ -575,6 +575,10 @@ static int omap_i2c_xfer_msg(struct i2c_adapter *adap,
 			if (time_after(jiffies, delay)) {
 				dev_err(dev->dev, "controller timed out "
 				"waiting for start condition to finish\n");
+				/* msg->buf must be out of the handler's reach */
+				disable_irq(dev->irq);
+				dev->buf_len = 0;
+				enable_irq(dev->irq);
 				return -ETIMEDOUT;
 			}
 			cpu_relax();
@@ -591,14 +595,23 @@ static int omap_i2c_xfer_msg(struct i2c_adapter *adap,
 	 */
 	r = wait_for_completion_timeout(&dev->cmd_complete,
 					OMAP_I2C_TIMEOUT);
-	dev->buf_len = 0;
-	if (r < 0)
-		return r;
 	if (r == 0) {
 		dev_err(dev->dev, "controller timed out\n");
+		/*
+		 * The threaded handler may still be moving data through
+		 * msg->buf; keep it off while the controller is reset.
+		 */
+		disable_irq(dev->irq);
+		dev->buf_len = 0;
 		omap_i2c_init(dev);
+		enable_irq(dev->irq);
 		return -ETIMEDOUT;
 	}
+	/* the handler completes the command before it returns */
+	synchronize_irq(dev->irq);
+	dev->buf_len = 0;
+	if (r < 0)
+		return r;
 
 	if (likely(!dev->cmd_err))
 		return 0;
@@ -799,8 +812,28 @@ static int errata_omap3_1p153(struct omap_i2c_dev *dev, u16 *stat, int *err)
 	return 0;
 }
 
+/*
+ * Hard IRQ half: only check that the interrupt is ours.  The line is
+ * requested IRQF_ONESHOT, so it stays masked until the thread below has
+ * moved the data and acked the status.
+ */
 static irqreturn_t
 omap_i2c_isr(int this_irq, void *dev_id)
+{
+	struct omap_i2c_dev *dev = dev_id;
+	u16 mask, stat;
+
+	if (pm_runtime_suspended(dev->dev))
+		return IRQ_NONE;
+
+	mask = omap_i2c_read_reg(dev, OMAP_I2C_IE_REG);
+	stat = omap_i2c_read_reg(dev, OMAP_I2C_STAT_REG);
+
+	return (stat & mask) ? IRQ_WAKE_THREAD : IRQ_NONE;
+}
+
+static irqreturn_t
+omap_i2c_isr_thread(int this_irq, void *dev_id)
 {
 	struct omap_i2c_dev *dev = dev_id;
 	u16 bits;
@@ -810,9 +843,6 @@ omap_i2c_isr(int this_irq, void *dev_id)
 
 	pdata = dev->dev->platform_data;
 
-	if (pm_runtime_suspended(dev->dev))
-		return IRQ_NONE;
-
 	bits = omap_i2c_read_reg(dev, OMAP_I2C_IE_REG);
 	while ((stat = (omap_i2c_read_reg(dev, OMAP_I2C_STAT_REG))) & bits) {
 		dev_dbg(dev->dev, "IRQ (ISR = 0x%04x)\n", stat);
@@ -972,7 +1002,6 @@ omap_i2c_probe(struct platform_device *pdev)
 	struct i2c_adapter	*adap;
 	struct resource		*mem, *irq, *ioarea;
 	struct omap_i2c_bus_platform_data *pdata = pdev->dev.platform_data;
-	irq_handler_t isr;
 	int r;
 	u32 speed = 0;
 
@@ -1064,15 +1093,24 @@ omap_i2c_probe(struct platform_device *pdev)
 	/* reset ASAP, clearing any IRQs */
 	omap_i2c_init(dev);
 
-	isr = (dev->rev < OMAP_I2C_OMAP1_REV_2) ? omap_i2c_omap1_isr :
-								   omap_i2c_isr;
-	r = request_irq(dev->irq, isr, 0, pdev->name, dev);
+	if (dev->rev < OMAP_I2C_OMAP1_REV_2)
+		r = request_irq(dev->irq, omap_i2c_omap1_isr, 0,
+				pdev->name, dev);
+	else
+		r = request_threaded_irq(dev->irq, omap_i2c_isr,
+					 omap_i2c_isr_thread, IRQF_ONESHOT,
+					 pdev->name, dev);
 
 	if (r) {
 		dev_err(dev->dev, "failure requesting irq %i\n", dev->irq);
 		goto err_unuse_clocks;
 	}
 
+	if (pdata->irq_thread_prio &&
+	    irq_set_thread_priority(dev->irq, dev, pdata->irq_thread_prio))
+		dev_warn(dev->dev, "could not set irq thread priority %u\n",
+			 pdata->irq_thread_prio);
+
 	dev_info(dev->dev, "bus %d rev%d.%d.%d at %d kHz\n", pdev->id,
 		 pdata->rev, dev->rev >> 4, dev->rev & 0xf, dev->speed);
 
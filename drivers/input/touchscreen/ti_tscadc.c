@@ -448,7 +448,8 @@ static irqreturn_t tsc_interrupt(int irq, void *dev)
 		irqclr |= TSCADC_IRQENB_FIFO1THRES;
 	}
 
-	udelay(315);
+	/* Runs in the irq thread, so the pen up settle time can sleep */
+	usleep_range(315, 400);
 
 	status = tscadc_readl(ts_dev, TSCADC_REG_RAWIRQSTATUS);
 	if (status & TSCADC_IRQENB_PENUP) {
@@ -587,12 +588,18 @@ static	int __devinit tscadc_probe(struct platform_device *pdev)
 		goto err_release_mem;
 	}
 
+	/*
+	 * All the work, FIFO draining included, is done in the irq thread;
+	 * IRQF_ONESHOT keeps the line masked until it is done.
+	 */
 	if(pdata->mode == TI_TSCADC_TSCMODE) {
-		err = request_irq(ts_dev->irq, tsc_interrupt, IRQF_DISABLED,
-					pdev->dev.driver->name, ts_dev);
+		err = request_threaded_irq(ts_dev->irq, NULL, tsc_interrupt,
+					IRQF_ONESHOT, pdev->dev.driver->name,
+					ts_dev);
 	}
 	else {
-		err = request_irq(ts_dev->irq, tsc_adc_interrupt, IRQF_DISABLED,
+		err = request_threaded_irq(ts_dev->irq, NULL,
+					tsc_adc_interrupt, IRQF_ONESHOT,
 					pdev->dev.driver->name, ts_dev);
 	}
 
@@ -601,6 +608,12 @@ static	int __devinit tscadc_probe(struct platform_device *pdev)
 		goto err_unmap_regs;
 	}
 
+	if (pdata->irq_thread_prio &&
+	    irq_set_thread_priority(ts_dev->irq, ts_dev,
+				    pdata->irq_thread_prio))
+		dev_warn(&pdev->dev, "could not set irq thread priority %d\n",
+			 pdata->irq_thread_prio);
+
 	pm_runtime_enable(&pdev->dev);
 	pm_runtime_get_sync(&pdev->dev);
 
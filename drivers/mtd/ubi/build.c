@@ -44,6 +44,7 @@
 #include <linux/kthread.h>
 #include <linux/kernel.h>
 #include <linux/slab.h>
+#include <linux/math64.h>
 #include "ubi.h"
 
 /* Maximum length of the 'mtd=' parameter */
@@ -131,6 +132,16 @@ static struct device_attribute dev_bgt_enabled =
 	__ATTR(bgt_enabled, S_IRUGO, dev_attribute_show, NULL);
 static struct device_attribute dev_mtd_num =
 	__ATTR(mtd_num, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_free_eraseblocks =
+	__ATTR(free_eraseblocks, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_free_eraseblocks_min =
+	__ATTR(free_eraseblocks_min, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_erase_count =
+	__ATTR(erase_count, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_erase_time_avg =
+	__ATTR(erase_time_avg, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_erase_time_max =
+	__ATTR(erase_time_max, S_IRUGO, dev_attribute_show, NULL);
 
 /**
  * ubi_volume_notify - send a volume change notification.
@@ -355,7 +366,32 @@ static ssize_t dev_attribute_show(struct device *dev,
 		ret = sprintf(buf, "%d\n", ubi->thread_enabled);
 	else if (attr == &dev_mtd_num)
 		ret = sprintf(buf, "%d\n", ubi->mtd->index);
-	else
+	else if (attr == &dev_free_eraseblocks)
+		ret = sprintf(buf, "%d\n", ubi->free_count);
+	else if (attr == &dev_free_eraseblocks_min)
+		ret = sprintf(buf, "%d\n", ubi->free_min);
+	else if (attr == &dev_erase_count) {
+		unsigned long long count;
+
+		/* 64-bit, so it may tear on 32-bit without the lock */
+		spin_lock(&ubi->wl_lock);
+		count = ubi->erase_count;
+		spin_unlock(&ubi->wl_lock);
+		ret = sprintf(buf, "%llu\n", count);
+	} else if (attr == &dev_erase_time_avg || attr == &dev_erase_time_max) {
+		unsigned long long time;
+
+		/* Erase times are reported in microseconds */
+		spin_lock(&ubi->wl_lock);
+		if (attr == &dev_erase_time_max)
+			time = ubi->erase_time_max;
+		else if (ubi->erase_count)
+			time = div64_u64(ubi->erase_time, ubi->erase_count);
+		else
+			time = 0;
+		spin_unlock(&ubi->wl_lock);
+		ret = sprintf(buf, "%llu\n", div_u64(time, NSEC_PER_USEC));
+	} else
 		ret = -EINVAL;
 
 	ubi_put_device(ubi);
@@ -422,6 +458,21 @@ static int ubi_sysfs_init(struct ubi_device *ubi, int *ref)
 	if (err)
 		return err;
 	err = device_create_file(&ubi->dev, &dev_mtd_num);
+	if (err)
+		return err;
+	err = device_create_file(&ubi->dev, &dev_free_eraseblocks);
+	if (err)
+		return err;
+	err = device_create_file(&ubi->dev, &dev_free_eraseblocks_min);
+	if (err)
+		return err;
+	err = device_create_file(&ubi->dev, &dev_erase_count);
+	if (err)
+		return err;
+	err = device_create_file(&ubi->dev, &dev_erase_time_avg);
+	if (err)
+		return err;
+	err = device_create_file(&ubi->dev, &dev_erase_time_max);
 	return err;
 }
 
@@ -431,6 +482,11 @@ static int ubi_sysfs_init(struct ubi_device *ubi, int *ref)
  */
 static void ubi_sysfs_close(struct ubi_device *ubi)
 {
+	device_remove_file(&ubi->dev, &dev_erase_time_max);
+	device_remove_file(&ubi->dev, &dev_erase_time_avg);
+	device_remove_file(&ubi->dev, &dev_erase_count);
+	device_remove_file(&ubi->dev, &dev_free_eraseblocks_min);
+	device_remove_file(&ubi->dev, &dev_free_eraseblocks);
 	device_remove_file(&ubi->dev, &dev_mtd_num);
 	device_remove_file(&ubi->dev, &dev_bgt_enabled);
 	device_remove_file(&ubi->dev, &dev_min_io_size);
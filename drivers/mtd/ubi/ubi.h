@@ -341,9 +341,13 @@ struct ubi_wl_entry;
  * @pq: protection queue (contain physical eraseblocks which are temporarily
  *      protected from the wear-leveling worker)
  * @pq_head: protection queue head
- * @wl_lock: protects the @used, @free, @pq, @pq_head, @lookuptbl, @move_from,
- *	     @move_to, @move_to_put @erase_pending, @wl_scheduled, @works,
- *	     @erroneous, and @erroneous_peb_count fields
+ * @free_count: count of physical eraseblocks in @free
+ * @free_min: the lowest value @free_count has dropped to
+ * @erase_pending: count of erase works in @works
+ * @wl_lock: protects the @used, @free, @free_count, @free_min, @pq, @pq_head,
+ *	     @lookuptbl, @move_from, @move_to, @move_to_put @erase_pending,
+ *	     @wl_scheduled, @works, @erroneous, @erroneous_peb_count and the
+ *	     erase statistics fields
  * @move_mutex: serializes eraseblock moves
  * @work_sem: synchronizes the WL worker with use tasks
  * @wl_scheduled: non-zero if the wear-leveling was scheduled
@@ -357,6 +361,9 @@ struct ubi_wl_entry;
  * @bgt_thread: background thread description object
  * @thread_enabled: if the background thread is enabled
  * @bgt_name: background thread name
+ * @erase_count: count of erase operations done since the device was attached
+ * @erase_time: total time spent in erase operations (nanoseconds)
+ * @erase_time_max: the longest erase operation (nanoseconds)
  *
  * @flash_size: underlying MTD device size (in bytes)
  * @peb_count: count of physical eraseblocks on the MTD device
@@ -430,6 +437,9 @@ struct ubi_device {
 	struct rb_root used;
 	struct rb_root erroneous;
 	struct rb_root free;
+	int free_count;
+	int free_min;
+	int erase_pending;
 	struct rb_root scrub;
 	struct list_head pq[UBI_PROT_QUEUE_LEN];
 	int pq_head;
@@ -446,6 +456,9 @@ struct ubi_device {
 	struct task_struct *bgt_thread;
 	int thread_enabled;
 	char bgt_name[sizeof(UBI_BGT_NAME_PATTERN)+2];
+	unsigned long long erase_count;
+	unsigned long long erase_time;
+	unsigned long long erase_time_max;
 
 	/* I/O sub-system's stuff */
 	long long flash_size;
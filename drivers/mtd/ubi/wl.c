@@ -110,6 +110,7 @@
 #include <linux/crc32.h>
 #include <linux/freezer.h>
 #include <linux/kthread.h>
+#include <linux/ktime.h>
 #include "ubi.h"
 
 /* Number of physical eraseblocks reserved for wear-leveling purposes */
@@ -136,6 +137,14 @@
  */
 #define WL_FREE_MAX_DIFF (2*UBI_WL_THRESHOLD)
 
+/*
+ * Desired number of erased physical eraseblocks in the @ubi->free tree. While
+ * there are fewer free PEBs than this, erase works are queued in front of all
+ * other works and wear-leveling is postponed, so that the background thread
+ * refills the pool before users of 'ubi_wl_get_peb()' have to wait.
+ */
+#define UBI_FREE_POOL CONFIG_MTD_UBI_FREE_POOL
+
 /*
  * Maximum number of consecutive background thread failures which is enough to
  * switch to read-only mode.
@@ -457,6 +466,9 @@ retry:
 	 * be protected from being moved for some time.
 	 */
 	rb_erase(&e->u.rb, &ubi->free);
+	ubi->free_count -= 1;
+	if (ubi->free_count < ubi->free_min)
+		ubi->free_min = ubi->free_count;
 	dbg_wl("PEB %d EC %d", e->pnum, e->ec);
 	prot_queue_add(ubi, e);
 	spin_unlock(&ubi->wl_lock);
@@ -509,7 +521,8 @@ static int sync_erase(struct ubi_device *ubi, struct ubi_wl_entry *e,
 {
 	int err;
 	struct ubi_ec_hdr *ec_hdr;
-	unsigned long long ec = e->ec;
+	unsigned long long ec = e->ec, time;
+	ktime_t start;
 
 	dbg_wl("erase PEB %d, old EC %llu", e->pnum, ec);
 
@@ -521,9 +534,11 @@ static int sync_erase(struct ubi_device *ubi, struct ubi_wl_entry *e,
 	if (!ec_hdr)
 		return -ENOMEM;
 
+	start = ktime_get();
 	err = ubi_io_sync_erase(ubi, e->pnum, torture);
 	if (err < 0)
 		goto out_free;
+	time = ktime_to_ns(ktime_sub(ktime_get(), start));
 
 	ec += err;
 	if (ec > UBI_MAX_ERASECOUNTER) {
@@ -549,6 +564,10 @@ static int sync_erase(struct ubi_device *ubi, struct ubi_wl_entry *e,
 	spin_lock(&ubi->wl_lock);
 	if (e->ec > ubi->max_ec)
 		ubi->max_ec = e->ec;
+	ubi->erase_count += 1;
+	ubi->erase_time += time;
+	if (time > ubi->erase_time_max)
+		ubi->erase_time_max = time;
 	spin_unlock(&ubi->wl_lock);
 
 out_free:
@@ -600,18 +619,29 @@ repeat:
 	spin_unlock(&ubi->wl_lock);
 }
 
+static int erase_worker(struct ubi_device *ubi, struct ubi_work *wl_wrk,
+			int cancel);
+
 /**
  * schedule_ubi_work - schedule a work.
  * @ubi: UBI device description object
  * @wrk: the work to schedule
  *
  * This function adds a work defined by @wrk to the tail of the pending works
- * list.
+ * list. Erase works are added to the head of the list instead if the pool of
+ * free physical eraseblocks has to be refilled.
  */
 static void schedule_ubi_work(struct ubi_device *ubi, struct ubi_work *wrk)
 {
 	spin_lock(&ubi->wl_lock);
-	list_add_tail(&wrk->list, &ubi->works);
+	if (wrk->func == &erase_worker) {
+		ubi->erase_pending += 1;
+		if (ubi->free_count < UBI_FREE_POOL)
+			list_add(&wrk->list, &ubi->works);
+		else
+			list_add_tail(&wrk->list, &ubi->works);
+	} else
+		list_add_tail(&wrk->list, &ubi->works);
 	ubi_assert(ubi->works_count >= 0);
 	ubi->works_count += 1;
 	if (ubi->thread_enabled && !ubi_dbg_is_bgt_disabled(ubi))
@@ -619,9 +649,6 @@ static void schedule_ubi_work(struct ubi_device *ubi, struct ubi_work *wrk)
 	spin_unlock(&ubi->wl_lock);
 }
 
-static int erase_worker(struct ubi_device *ubi, struct ubi_work *wl_wrk,
-			int cancel);
-
 /**
  * schedule_erase - schedule an erase work.
  * @ubi: UBI device description object
@@ -729,6 +756,9 @@ static int wear_leveling_worker(struct ubi_device *ubi, struct ubi_work *wrk,
 
 	paranoid_check_in_wl_tree(ubi, e2, &ubi->free);
 	rb_erase(&e2->u.rb, &ubi->free);
+	ubi->free_count -= 1;
+	if (ubi->free_count < ubi->free_min)
+		ubi->free_min = ubi->free_count;
 	ubi->move_from = e1;
 	ubi->move_to = e2;
 	spin_unlock(&ubi->wl_lock);
@@ -966,6 +996,16 @@ static int ensure_wear_leveling(struct ubi_device *ubi)
 			/* No physical eraseblocks - no deal */
 			goto out_unlock;
 
+		/*
+		 * Moving data takes one more free physical eraseblock, so do
+		 * not do this while the free pool is still being refilled.
+		 * This function is called again after each erasure, so
+		 * wear-leveling will be re-considered once the pending
+		 * erasures are done.
+		 */
+		if (ubi->free_count < UBI_FREE_POOL && ubi->erase_pending)
+			goto out_unlock;
+
 		/*
 		 * We schedule wear-leveling only if the difference between the
 		 * lowest erase counter of used physical eraseblocks and a high
@@ -1019,6 +1059,11 @@ static int erase_worker(struct ubi_device *ubi, struct ubi_work *wl_wrk,
 	struct ubi_wl_entry *e = wl_wrk->e;
 	int pnum = e->pnum, err, need;
 
+	spin_lock(&ubi->wl_lock);
+	ubi->erase_pending -= 1;
+	ubi_assert(ubi->erase_pending >= 0);
+	spin_unlock(&ubi->wl_lock);
+
 	if (cancel) {
 		dbg_wl("cancel erasure of PEB %d EC %d", pnum, e->ec);
 		kfree(wl_wrk);
@@ -1035,6 +1080,7 @@ static int erase_worker(struct ubi_device *ubi, struct ubi_work *wl_wrk,
 
 		spin_lock(&ubi->wl_lock);
 		wl_tree_add(e, &ubi->free);
+		ubi->free_count += 1;
 		spin_unlock(&ubi->wl_lock);
 
 		/*
@@ -1480,8 +1526,10 @@ int ubi_wl_init_scan(struct ubi_device *ubi, struct ubi_scan_info *si)
 		e->ec = seb->ec;
 		ubi_assert(e->ec >= 0);
 		wl_tree_add(e, &ubi->free);
+		ubi->free_count += 1;
 		ubi->lookuptbl[e->pnum] = e;
 	}
+	ubi->free_min = ubi->free_count;
 
 	ubi_rb_for_each_entry(rb1, sv, &si->volumes, rb) {
 		ubi_rb_for_each_entry(rb2, seb, &sv->root, u.rb) {
@@ -21,6 +21,16 @@
 #include <linux/pwm/pwm.h>
 #include <linux/slab.h>
 #include <linux/pm_runtime.h>
+#include <linux/interrupt.h>
+#include <linux/miscdevice.h>
+#include <linux/fs.h>
+#include <linux/poll.h>
+#include <linux/kfifo.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
+#include <linux/wait.h>
+#include <linux/uaccess.h>
+#include <linux/pwm/ecap.h>
 
 #include <plat/clock.h>
 #include <plat/config_pwm.h>
@@ -30,7 +40,20 @@
 #define CAPTURE_2_REG			0x0c
 #define CAPTURE_3_REG			0x10
 #define CAPTURE_4_REG			0x14
+#define CAPTURE_CTRL1_REG		0x28
 #define CAPTURE_CTRL2_REG		0x2A
+#define CAPTURE_INTEN_REG		0x2C
+#define CAPTURE_INTFLG_REG		0x2E
+#define CAPTURE_INTCLR_REG		0x30
+
+#define ECTRL1_CAPPOL_FALL(n)		BIT(2 * (n))
+#define ECTRL1_CAPPOL_MASK		0x55
+#define ECTRL1_CAPLDEN			BIT(8)
+#define ECTRL1_FREE_SOFT		(0x03 << 14)
+
+#define ECTRL2_ONESHOT			BIT(0)
+#define ECTRL2_STOP_WRAP_CAP4		(0x03 << 1)
+#define ECTRL2_REARM			BIT(3)
 
 #define ECTRL2_SYNCOSEL_MASK		(0x03 << 6)
 
@@ -39,13 +62,24 @@
 #define ECTRL2_PLSL_LOW			BIT(10)
 #define ECTRL2_SYNC_EN			BIT(5)
 
+#define ECINT_INT			BIT(0)
+#define ECINT_CEVT(n)			BIT(1 + (n))
+#define ECINT_CEVT_ALL			(0x0f << 1)
+#define ECINT_CTROVF			BIT(5)
+
+/* Events buffered between the interrupt handler and read() */
+#define ECAP_CAPTURE_FIFO_LEN		256
+#define ECAP_NUM_CAPTURE		4
+
 struct ecap_regs {
 	unsigned	tsctr;
 	unsigned	cap1;
 	unsigned	cap2;
 	unsigned	cap3;
 	unsigned	cap4;
+	unsigned short	ecctl1;
 	unsigned short	ecctl2;
+	unsigned short	eceint;
 	unsigned short	clkconfig;
 };
 
@@ -59,6 +93,19 @@ struct ecap_pwm {
 	void __iomem *config_mem_base;
 	struct device *dev;
 	struct ecap_regs ctx;
+
+	/* Input capture */
+	int		irq;
+	char		name[8];
+	struct miscdevice miscdev;
+	struct mutex	read_lock;
+	wait_queue_head_t capture_wait;
+	DECLARE_KFIFO(capture_fifo, struct ecap_capture_event,
+			ECAP_CAPTURE_FIFO_LEN);
+	u64		epoch;
+	u32		edges;
+	u32		lost;
+	unsigned	capture_next;
 };
 
 static inline struct ecap_pwm *to_ecap_pwm(const struct pwm_device *p)
@@ -240,6 +287,298 @@ static int ecap_frequency_transition_cb(struct pwm_device *p)
 		return 0;
 }
 
+static u32 ecap_capture_edge(struct ecap_pwm *ep, unsigned n)
+{
+	if (ep->edges != ECAP_EDGE_BOTH)
+		return ep->edges;
+
+	return (n & 1) ? ECAP_EDGE_FALLING : ECAP_EDGE_RISING;
+}
+
+static void ecap_capture_set_edges(struct ecap_pwm *ep, u32 edges)
+{
+	unsigned long flags, v;
+	unsigned n;
+
+	spin_lock_irqsave(&ep->lock, flags);
+	ep->edges = edges;
+	v = readw(ep->mmio_base + CAPTURE_CTRL1_REG);
+	v &= ~ECTRL1_CAPPOL_MASK;
+	for (n = 0; n < ECAP_NUM_CAPTURE; n++)
+		if (ecap_capture_edge(ep, n) == ECAP_EDGE_FALLING)
+			v |= ECTRL1_CAPPOL_FALL(n);
+	writew(v, ep->mmio_base + CAPTURE_CTRL1_REG);
+	spin_unlock_irqrestore(&ep->lock, flags);
+}
+
+static void ecap_capture_push(struct ecap_pwm *ep, u64 ts, u32 edge)
+{
+	struct ecap_capture_event ev;
+
+	ev.timestamp = ts;
+	ev.edge = edge;
+	ev.lost = ep->lost;
+
+	if (kfifo_put(&ep->capture_fifo, &ev))
+		ep->lost = 0;
+	else
+		ep->lost++;
+}
+
+/*
+ * The module runs in continuous mode, wrapping after CAP4, so edges are
+ * latched into CAP1..CAP4 in turn and the hardware buffers up to four of
+ * them between interrupts.  The 32-bit counter is extended in software
+ * using the overflow event.
+ */
+static irqreturn_t ecap_capture_isr(int irq, void *dev_id)
+{
+	struct ecap_pwm *ep = dev_id;
+	unsigned long flags;
+	u32 now, pending, ovf, cap;
+	u64 ts;
+	unsigned n, next, i;
+
+	spin_lock_irqsave(&ep->lock, flags);
+
+	/*
+	 * Only the capture events flagged before the counter is sampled are
+	 * handled here, so that each of them is known to precede "now".
+	 */
+	pending = readw(ep->mmio_base + CAPTURE_INTFLG_REG);
+	now = readl(ep->mmio_base + TIMER_CTR_REG);
+	ovf = readw(ep->mmio_base + CAPTURE_INTFLG_REG) & ECINT_CTROVF;
+
+	/*
+	 * An overflow seen with the counter still in its upper half happened
+	 * after "now" was sampled; leave it pending for the next interrupt.
+	 */
+	if (ovf && now < BIT(31)) {
+		ep->epoch += 1ULL << 32;
+		writew(ECINT_CTROVF, ep->mmio_base + CAPTURE_INTCLR_REG);
+	}
+
+	n = ep->capture_next;
+	while (pending & ECINT_CEVT(n)) {
+		cap = readl(ep->mmio_base + CAPTURE_1_REG + 4 * n);
+		writew(ECINT_CEVT(n), ep->mmio_base + CAPTURE_INTCLR_REG);
+		pending &= ~ECINT_CEVT(n);
+
+		ts = ep->epoch + cap;
+		if (cap > now)
+			ts -= 1ULL << 32;
+		ecap_capture_push(ep, ts, ecap_capture_edge(ep, n));
+
+		n = (n + 1) % ECAP_NUM_CAPTURE;
+	}
+
+	/*
+	 * Any other capture flag means the sequencer wrapped before we got
+	 * here and overwrote registers we had not read yet.  Drop those
+	 * events and resynchronize after the most recent one.
+	 */
+	next = n;
+	for (i = 0; i < ECAP_NUM_CAPTURE; i++, n = (n + 1) % ECAP_NUM_CAPTURE) {
+		if (!(pending & ECINT_CEVT(n)))
+			continue;
+		writew(ECINT_CEVT(n), ep->mmio_base + CAPTURE_INTCLR_REG);
+		ep->lost++;
+		next = (n + 1) % ECAP_NUM_CAPTURE;
+	}
+	ep->capture_next = next;
+
+	writew(ECINT_INT, ep->mmio_base + CAPTURE_INTCLR_REG);
+	spin_unlock_irqrestore(&ep->lock, flags);
+
+	wake_up_interruptible(&ep->capture_wait);
+
+	return IRQ_HANDLED;
+}
+
+static int ecap_capture_open(struct inode *inode, struct file *file)
+{
+	struct ecap_pwm *ep = container_of(file->private_data,
+					struct ecap_pwm, miscdev);
+	unsigned long flags, v;
+
+	/* Capture and PWM output share the module, claim it like pwm_request */
+	if (test_and_set_bit(FLAG_REQUESTED, &ep->pwm.flags))
+		return -EBUSY;
+	ep->pwm.label = ep->name;
+
+	pm_runtime_get_sync(ep->dev);
+
+	spin_lock_irqsave(&ep->lock, flags);
+	writew(0, ep->mmio_base + CAPTURE_INTEN_REG);
+	writew(0xffff, ep->mmio_base + CAPTURE_INTCLR_REG);
+
+	v = readw(ep->mmio_base + CAPTURE_CTRL2_REG);
+	v &= ~(ECTRL2_MDSL_ECAP | ECTRL2_SYNC_EN | ECTRL2_SYNCOSEL_MASK |
+		ECTRL2_ONESHOT);
+	v |= ECTRL2_STOP_WRAP_CAP4 | ECTRL2_CTRSTP_FREERUN | ECTRL2_REARM;
+	writew(v, ep->mmio_base + CAPTURE_CTRL2_REG);
+
+	writew(ECTRL1_FREE_SOFT | ECTRL1_CAPLDEN,
+		ep->mmio_base + CAPTURE_CTRL1_REG);
+	writel(0, ep->mmio_base + TIMER_CTR_REG);
+
+	kfifo_reset(&ep->capture_fifo);
+	ep->epoch = 0;
+	ep->lost = 0;
+	ep->capture_next = 0;
+	spin_unlock_irqrestore(&ep->lock, flags);
+
+	ecap_capture_set_edges(ep, ECAP_EDGE_RISING);
+
+	writew(ECINT_CEVT_ALL | ECINT_CTROVF,
+		ep->mmio_base + CAPTURE_INTEN_REG);
+
+	file->private_data = ep;
+	return nonseekable_open(inode, file);
+}
+
+static int ecap_capture_release(struct inode *inode, struct file *file)
+{
+	struct ecap_pwm *ep = file->private_data;
+	unsigned long flags, v;
+
+	spin_lock_irqsave(&ep->lock, flags);
+	writew(0, ep->mmio_base + CAPTURE_INTEN_REG);
+	writew(0xffff, ep->mmio_base + CAPTURE_INTCLR_REG);
+	writew(0, ep->mmio_base + CAPTURE_CTRL1_REG);
+	v = readw(ep->mmio_base + CAPTURE_CTRL2_REG);
+	v &= ~(ECTRL2_CTRSTP_FREERUN | ECTRL2_REARM);
+	writew(v, ep->mmio_base + CAPTURE_CTRL2_REG);
+	spin_unlock_irqrestore(&ep->lock, flags);
+
+	synchronize_irq(ep->irq);
+	pm_runtime_put_sync(ep->dev);
+
+	ep->pwm.label = NULL;
+	clear_bit(FLAG_REQUESTED, &ep->pwm.flags);
+	return 0;
+}
+
+static ssize_t ecap_capture_read(struct file *file, char __user *buf,
+				size_t count, loff_t *ppos)
+{
+	struct ecap_pwm *ep = file->private_data;
+	unsigned int copied;
+	int ret;
+
+	if (count < sizeof(struct ecap_capture_event))
+		return -EINVAL;
+
+	if (mutex_lock_interruptible(&ep->read_lock))
+		return -ERESTARTSYS;
+
+	while (kfifo_is_empty(&ep->capture_fifo)) {
+		mutex_unlock(&ep->read_lock);
+		if (file->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+		if (wait_event_interruptible(ep->capture_wait,
+				!kfifo_is_empty(&ep->capture_fifo)))
+			return -ERESTARTSYS;
+		if (mutex_lock_interruptible(&ep->read_lock))
+			return -ERESTARTSYS;
+	}
+
+	ret = kfifo_to_user(&ep->capture_fifo, buf, count, &copied);
+	mutex_unlock(&ep->read_lock);
+
+	return ret ? ret : copied;
+}
+
+static unsigned int ecap_capture_poll(struct file *file, poll_table *wait)
+{
+	struct ecap_pwm *ep = file->private_data;
+
+	poll_wait(file, &ep->capture_wait, wait);
+
+	if (!kfifo_is_empty(&ep->capture_fifo))
+		return POLLIN | POLLRDNORM;
+	return 0;
+}
+
+static long ecap_capture_ioctl(struct file *file, unsigned int cmd,
+				unsigned long arg)
+{
+	struct ecap_pwm *ep = file->private_data;
+	u32 edges;
+
+	switch (cmd) {
+	case ECAPIOC_SET_EDGES:
+		if (get_user(edges, (u32 __user *)arg))
+			return -EFAULT;
+		if (!edges || (edges & ~ECAP_EDGE_BOTH))
+			return -EINVAL;
+		ecap_capture_set_edges(ep, edges);
+		return 0;
+
+	case ECAPIOC_GET_TICK_HZ:
+		return put_user(clk_get_rate(ep->clk), (u32 __user *)arg);
+	}
+
+	return -ENOTTY;
+}
+
+static const struct file_operations ecap_capture_fops = {
+	.owner		= THIS_MODULE,
+	.open		= ecap_capture_open,
+	.release	= ecap_capture_release,
+	.read		= ecap_capture_read,
+	.poll		= ecap_capture_poll,
+	.unlocked_ioctl	= ecap_capture_ioctl,
+	.llseek		= no_llseek,
+};
+
+/* Input capture needs the interrupt, instances without one are PWM only */
+static void ecap_capture_init(struct ecap_pwm *ep,
+				struct platform_device *pdev)
+{
+	int ret;
+
+	ep->irq = platform_get_irq(pdev, 0);
+	if (ep->irq < 0)
+		return;
+
+	mutex_init(&ep->read_lock);
+	init_waitqueue_head(&ep->capture_wait);
+	INIT_KFIFO(ep->capture_fifo);
+
+	ret = request_irq(ep->irq, ecap_capture_isr, 0, dev_name(&pdev->dev),
+			ep);
+	if (ret) {
+		dev_warn(&pdev->dev, "failed to request irq %d, capture "
+				"disabled\n", ep->irq);
+		ep->irq = -1;
+		return;
+	}
+
+	snprintf(ep->name, sizeof(ep->name), "ecap%d", pdev->id);
+	ep->miscdev.minor = MISC_DYNAMIC_MINOR;
+	ep->miscdev.name = ep->name;
+	ep->miscdev.fops = &ecap_capture_fops;
+	ep->miscdev.parent = &pdev->dev;
+
+	ret = misc_register(&ep->miscdev);
+	if (ret) {
+		dev_warn(&pdev->dev, "failed to register %s, capture "
+				"disabled\n", ep->name);
+		free_irq(ep->irq, ep);
+		ep->irq = -1;
+	}
+}
+
+static void ecap_capture_exit(struct ecap_pwm *ep)
+{
+	if (ep->irq < 0)
+		return;
+
+	misc_deregister(&ep->miscdev);
+	free_irq(ep->irq, ep);
+}
+
 static int ecap_probe(struct platform_device *pdev)
 {
 	struct ecap_pwm *ep = NULL;
@@ -330,6 +669,7 @@ static int ecap_probe(struct platform_device *pdev)
 	pwm_set_drvdata(&ep->pwm, ep);
 	ret =  pwm_register(&ep->pwm, &pdev->dev, -1);
 	platform_set_drvdata(pdev, ep);
+	ecap_capture_init(ep, pdev);
 	return 0;
 
 err_ioremap:
@@ -353,6 +693,8 @@ void ecap_save_reg(struct ecap_pwm *ep)
 {
 	pm_runtime_get_sync(ep->dev);
 
+	ep->ctx.eceint = readw(ep->mmio_base + CAPTURE_INTEN_REG);
+	ep->ctx.ecctl1 = readw(ep->mmio_base + CAPTURE_CTRL1_REG);
 	ep->ctx.ecctl2 = readw(ep->mmio_base + CAPTURE_CTRL2_REG);
 	ep->ctx.tsctr = readl(ep->mmio_base + TIMER_CTR_REG);
 	ep->ctx.cap1 = readl(ep->mmio_base + CAPTURE_1_REG);
@@ -374,7 +716,9 @@ void ecap_restore_reg(struct ecap_pwm *ep)
 	writel(ep->ctx.cap2, ep->mmio_base + CAPTURE_2_REG);
 	writel(ep->ctx.cap1, ep->mmio_base + CAPTURE_1_REG);
 	writel(ep->ctx.tsctr, ep->mmio_base + TIMER_CTR_REG);
+	writew(ep->ctx.ecctl1, ep->mmio_base + CAPTURE_CTRL1_REG);
 	writew(ep->ctx.ecctl2, ep->mmio_base + CAPTURE_CTRL2_REG);
+	writew(ep->ctx.eceint, ep->mmio_base + CAPTURE_INTEN_REG);
 }
 
 static int ecap_suspend(struct platform_device *pdev, pm_message_t state)
@@ -410,6 +754,8 @@ static int __devexit ecap_remove(struct platform_device *pdev)
 	struct pwmss_platform_data *pdata;
 	int val;
 
+	ecap_capture_exit(ep);
+
 	if (ep->version == PWM_VERSION_1) {
 		pdata = (&pdev->dev)->platform_data;
 		val = readw(ep->config_mem_base + PWMSS_CLKCONFIG);
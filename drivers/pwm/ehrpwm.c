@@ -17,6 +17,7 @@
 #include <linux/clk.h>
 #include <linux/err.h>
 #include <linux/io.h>
+#include <linux/delay.h>
 #include <linux/interrupt.h>
 #include <linux/platform_device.h>
 #include <linux/slab.h>
@@ -56,6 +57,9 @@
 #define TBCTL_FREERUN_FREE		0x2
 #define TBCTL_CTRMOD_CTRUP		0x0
 
+#define TBCTL_SYNCOSEL_SYNCI		0x0
+#define TBCTL_SYNCOSEL_CTRZERO		0x1
+
 /******************* Counter-Compare Sub Module ***********************/
 #define CMPCTL				0xE
 #define CMPA				0x12
@@ -168,6 +172,30 @@
 #define HRCNFG_LDMD_POS			0x3
 #define HRCNFG_CTLMD_POS		0x2
 
+#define HRCNFG_EDGEMD_RISE		0x1
+#define HRCNFG_EDGEMD_FALL		0x2
+
+/*
+ * Nominal MEP step of the high resolution module. The real step varies
+ * with process, voltage and temperature; a calibrated scale factor can be
+ * set with ehrpwm_hr_set_mep_scale().
+ */
+#define EHRPWM_MEP_STEP_PS		180
+#define EHRPWM_MEP_MAX_STEPS		253
+#define CMPAHR_ROUNDING			0x180
+
+/*
+ * Shadow registers of all modules in a sync group must be written within
+ * the same PWM period. Updates are deferred past the next counter wrap if
+ * fewer than this many nanoseconds are left in the current period.
+ */
+#define EHRPWM_SYNC_MARGIN_NS		2000
+/* the wrap is due within the margin; give up waiting after twice that */
+#define EHRPWM_SYNC_MAX_WAIT_US		\
+	DIV_ROUND_UP(2 * EHRPWM_SYNC_MARGIN_NS, NSEC_PER_USEC)
+
+static DEFINE_SPINLOCK(ehrpwm_sync_lock);
+
 struct ehrpwm_suspend_params {
 	struct pwm_device *pch;
 	unsigned long req_delay_cycles;
@@ -1082,10 +1110,69 @@ static int ehrpwm_pwm_set_prd(struct pwm_device *p)
 	return 0;
 }
 
+static inline unsigned int ehrpwm_hrcnfg_offset(struct ehrpwm_pwm *ehrpwm)
+{
+	return ehrpwm->version == PWM_VERSION_1 ? AM335X_HRCNFG : HRCNFG;
+}
+
+/* Number of MEP steps in one time base clock tick */
+static unsigned int ehrpwm_hr_mep_scale(struct ehrpwm_pwm *ehrpwm,
+		struct pwm_device *p)
+{
+	if (!ehrpwm->mep_sf && p->tick_hz)
+		ehrpwm->mep_sf = min_t(unsigned long,
+				div_u64(1000000000000ULL, p->tick_hz) /
+				EHRPWM_MEP_STEP_PS, 255);
+
+	return ehrpwm->mep_sf;
+}
+
+/*
+ * Compute the CMPAHR value for a fraction of a tick, given in units of
+ * 1/65536 tick.
+ */
+static unsigned short ehrpwm_hr_cmpahr(struct ehrpwm_pwm *ehrpwm,
+		struct pwm_device *p, unsigned int frac)
+{
+	unsigned int steps;
+
+	steps = (frac * ehrpwm_hr_mep_scale(ehrpwm, p)) >> 16;
+	if (steps > EHRPWM_MEP_MAX_STEPS)
+		steps = EHRPWM_MEP_MAX_STEPS;
+
+	return (steps << 8) + CMPAHR_ROUNDING;
+}
+
+/*
+ * Duty cycle control by CMPAHR, MEP placed on the edge generated by the
+ * CMPA match (falling edge for active high output, rising otherwise).
+ * Shadow loads of CMPAHR happen together with CMPA, on counter zero.
+ */
+static void ehrpwm_hr_enable(struct ehrpwm_pwm *ehrpwm, struct pwm_device *p)
+{
+	ehrpwm_write(ehrpwm, ehrpwm_hrcnfg_offset(ehrpwm),
+		p->active_high ? HRCNFG_EDGEMD_FALL : HRCNFG_EDGEMD_RISE);
+}
+
+/* Fraction of a tick in duty_ns not representable by duty_ticks */
+static unsigned int ehrpwm_hr_duty_frac(struct pwm_device *p)
+{
+	u64 ticks, frac;
+	u32 rem;
+
+	ticks = (u64)p->duty_ns * p->tick_hz;
+	rem = do_div(ticks, NSEC_PER_SEC);
+	if (ticks != p->duty_ticks)
+		return 0;
+
+	frac = (u64)rem << 16;
+	do_div(frac, NSEC_PER_SEC);
+
+	return frac;
+}
+
 static int ehrpwm_hr_duty_config(struct pwm_device *p)
 {
-	unsigned char no_of_mepsteps;
-	unsigned short cmphr_val;
 	struct ehrpwm_pwm *ehrpwm = to_ehrpwm_pwm(p);
 
 	if (!p->tick_hz) {
@@ -1093,26 +1180,12 @@ static int ehrpwm_hr_duty_config(struct pwm_device *p)
 		return -EINVAL;
 	}
 
-	/*
-	 * Calculate the no of MEP steps. Assume system clock
-	 * is in the order of MHZ.
-	 */
-	no_of_mepsteps = USEC_PER_SEC / ((p->tick_hz / USEC_PER_SEC) * 63);
-
 	pm_runtime_get_sync(ehrpwm->dev);
-	/* Calculate the CMPHR Value */
-	cmphr_val = p->tick_hz / USEC_PER_SEC;
-	cmphr_val = (p->duty_ns * cmphr_val) % MSEC_PER_SEC;
-	cmphr_val = (cmphr_val * no_of_mepsteps) / 1000;
-	cmphr_val = (cmphr_val << 8) + 0x180;
-	ehrpwm_write(ehrpwm, CMPAHR, cmphr_val);
-
-	if (ehrpwm->version == PWM_VERSION_1)
-		ehrpwm_write(ehrpwm, AM335X_HRCNFG, 0x2);
-	else
-		ehrpwm_write(ehrpwm, HRCNFG, 0x2);
-
+	ehrpwm_write(ehrpwm, CMPAHR,
+		ehrpwm_hr_cmpahr(ehrpwm, p, ehrpwm_hr_duty_frac(p)));
+	ehrpwm_hr_enable(ehrpwm, p);
 	pm_runtime_put_sync(ehrpwm->dev);
+
 	return 0;
 }
 
@@ -1134,20 +1207,240 @@ static int ehrpwm_pwm_set_dty(struct pwm_device *p)
 	debug("\n Prescaler value is %d", ehrpwm->prescale_val);
 	debug("\n duty ticks is %d", duty_ticks);
 	pm_runtime_get_sync(ehrpwm->dev);
-	/* High resolution module */
-	if (chan && ehrpwm->prescale_val <= 1) {
+	/* High resolution module, only available on channel A */
+	if (!chan && ehrpwm->prescale_val <= 1)
 		ret = ehrpwm_hr_duty_config(p);
-		if (ehrpwm->version == PWM_VERSION_1)
-			ehrpwm_write(ehrpwm, AM335X_HRCNFG, 0x2);
-		else
-			ehrpwm_write(ehrpwm, HRCNFG, 0x2);
-	}
+	else if (!chan)
+		ehrpwm_write(ehrpwm, ehrpwm_hrcnfg_offset(ehrpwm), 0);
 
 	ehrpwm_write(ehrpwm, (chan ? CMPB : CMPA), duty_ticks);
 	pm_runtime_put_sync(ehrpwm->dev);
 	return ret;
 }
 
+/**
+ * ehrpwm_hr_set_mep_scale - set the number of MEP steps per tick
+ * @p: PWM channel
+ * @steps: MEP steps in one time base clock period, as found by calibration
+ *
+ * The default is derived from the nominal MEP step size and is only
+ * approximate. It is reset whenever the functional clock rate changes.
+ */
+int ehrpwm_hr_set_mep_scale(struct pwm_device *p, unsigned int steps)
+{
+	struct ehrpwm_pwm *ehrpwm = to_ehrpwm_pwm(p);
+
+	if (!steps || steps > 255)
+		return -EINVAL;
+
+	ehrpwm->mep_sf = steps;
+
+	return 0;
+}
+EXPORT_SYMBOL(ehrpwm_hr_set_mep_scale);
+
+/**
+ * ehrpwm_hr_set_duty - set duty cycle with high resolution edge placement
+ * @p: PWM channel, must be channel A of the module
+ * @duty_ticks: duty cycle in ticks of p->tick_hz
+ * @frac: additional fraction of a tick, in units of 1/65536 tick
+ *
+ * Requires the time base to run undivided. CMPA and CMPAHR are loaded from
+ * their shadow registers together on the next counter wrap.
+ */
+int ehrpwm_hr_set_duty(struct pwm_device *p, unsigned long duty_ticks,
+		unsigned int frac)
+{
+	struct ehrpwm_pwm *ehrpwm = to_ehrpwm_pwm(p);
+	unsigned long flags;
+
+	if (p != &ehrpwm->pwm[0] || ehrpwm->prescale_val > 1 ||
+			duty_ticks > 0xffff || frac > 0xffff)
+		return -EINVAL;
+
+	pm_runtime_get_sync(ehrpwm->dev);
+	spin_lock_irqsave(&ehrpwm->lock, flags);
+	ehrpwm_hr_enable(ehrpwm, p);
+	ehrpwm_write(ehrpwm, CMPAHR, ehrpwm_hr_cmpahr(ehrpwm, p, frac));
+	ehrpwm_write(ehrpwm, CMPA, duty_ticks);
+	spin_unlock_irqrestore(&ehrpwm->lock, flags);
+	pm_runtime_put_sync(ehrpwm->dev);
+
+	p->duty_ticks = duty_ticks;
+	p->duty_ns = pwm_ticks_to_ns(p, duty_ticks);
+
+	return 0;
+}
+EXPORT_SYMBOL(ehrpwm_hr_set_duty);
+
+/**
+ * ehrpwm_sync_group_init - synchronize the time bases of several modules
+ * @p: PWM channels, in the order of the SYNCI/SYNCO daisy chain
+ * @n: number of entries in @p
+ *
+ * The module of p[0] becomes the master and emits a sync pulse on every
+ * counter wrap. The following modules load a zero phase on that pulse and
+ * pass it on down the chain, so that all counters wrap together. Period
+ * and compare registers of every module are switched to shadow mode with
+ * loads on counter zero, which lets ehrpwm_sync_update() change all of
+ * them at the same instant.
+ */
+int ehrpwm_sync_group_init(struct pwm_device **p, unsigned int n)
+{
+	struct ehrpwm_pwm *master, *ehrpwm;
+	unsigned int i;
+
+	if (!n)
+		return -EINVAL;
+
+	master = to_ehrpwm_pwm(p[0]);
+
+	for (i = 0; i < n; i++) {
+		ehrpwm = to_ehrpwm_pwm(p[i]);
+
+		pm_runtime_get_sync(ehrpwm->dev);
+		ehrpwm_tb_set_periodload(p[i], 0);
+		ehrpwm_cmp_set_cmp_ctl(p[i], 0, 0, 0, 0);
+		ehrpwm_reg_config(ehrpwm, ehrpwm_hrcnfg_offset(ehrpwm),
+				0, BIT(HRCNFG_LDMD_POS));
+
+		if (ehrpwm == master) {
+			ehrpwm_tb_config_sync(p[i], 0, TBCTL_SYNCOSEL_CTRZERO);
+		} else {
+			ehrpwm_tb_set_phase(p[i], 0);
+			ehrpwm_tb_config_sync(p[i], 1, TBCTL_SYNCOSEL_SYNCI);
+		}
+		pm_runtime_put_sync(ehrpwm->dev);
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL(ehrpwm_sync_group_init);
+
+/* is the module of upd[i] also the module of an earlier entry? */
+static bool ehrpwm_sync_seen(struct ehrpwm_update *upd, unsigned int i)
+{
+	unsigned int j;
+
+	for (j = 0; j < i; j++)
+		if (to_ehrpwm_pwm(upd[j].p) == to_ehrpwm_pwm(upd[i].p))
+			return true;
+	return false;
+}
+
+/**
+ * ehrpwm_sync_update - atomically update several PWM channels
+ * @upd: new settings, one entry per channel, upd[0] on the sync master
+ * @n: number of entries in @upd
+ *
+ * Writes all period and compare values to the shadow registers within a
+ * single PWM period, so that they take effect together on the next
+ * counter wrap of the group set up by ehrpwm_sync_group_init(). If the
+ * master counter is close to wrapping, the writes are held back until
+ * the wrap has happened. All channels must be running and the counters
+ * must count up. When both channels of a module set a period, the last
+ * one wins. May sleep.
+ */
+int ehrpwm_sync_update(struct ehrpwm_update *upd, unsigned int n)
+{
+	struct ehrpwm_pwm *master, *ehrpwm;
+	struct pwm_device *p;
+	unsigned long flags;
+	unsigned short prd, ctr, last, margin;
+	unsigned int i, waited;
+	int chan;
+
+	if (!n)
+		return -EINVAL;
+
+	for (i = 0; i < n; i++) {
+		p = upd[i].p;
+		ehrpwm = to_ehrpwm_pwm(p);
+		chan = p - &ehrpwm->pwm[0];
+
+		if (!pwm_is_running(p))
+			return -EPERM;
+		if (upd[i].period_ticks && (upd[i].period_ticks /
+				ehrpwm->prescale_val - 1 > 0xffff ||
+				upd[i].period_ticks / ehrpwm->prescale_val < 2))
+			return -EINVAL;
+		if (upd[i].duty_ticks / ehrpwm->prescale_val > 0xffff)
+			return -EINVAL;
+		if (upd[i].duty_frac && (chan || ehrpwm->prescale_val > 1))
+			return -EINVAL;
+	}
+
+	master = to_ehrpwm_pwm(upd[0].p);
+	margin = min_t(unsigned long, 0xffff,
+		pwm_ns_to_ticks(upd[0].p, EHRPWM_SYNC_MARGIN_NS) /
+		master->prescale_val);
+
+	for (i = 0; i < n; i++)
+		pm_runtime_get_sync(to_ehrpwm_pwm(upd[i].p)->dev);
+
+	/* sync updates are serialized, so the module locks nest safely */
+	spin_lock_irqsave(&ehrpwm_sync_lock, flags);
+	for (i = 0; i < n; i++)
+		if (!ehrpwm_sync_seen(upd, i))
+			spin_lock_nest_lock(&to_ehrpwm_pwm(upd[i].p)->lock,
+					    &ehrpwm_sync_lock);
+
+	prd = ehrpwm_read(master, TBPRD);
+	if (prd > margin) {
+		last = 0;
+		for (waited = 0; waited < EHRPWM_SYNC_MAX_WAIT_US; waited++) {
+			ctr = ehrpwm_read(master, TBCTR);
+			if (ctr < prd - margin || ctr < last)
+				break;
+			last = ctr;
+			udelay(1);
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		p = upd[i].p;
+		ehrpwm = to_ehrpwm_pwm(p);
+		chan = p - &ehrpwm->pwm[0];
+
+		if (upd[i].period_ticks)
+			ehrpwm_write(ehrpwm, TBPRD, upd[i].period_ticks /
+					ehrpwm->prescale_val - 1);
+		if (!chan && ehrpwm->prescale_val <= 1) {
+			ehrpwm_hr_enable(ehrpwm, p);
+			ehrpwm_write(ehrpwm, CMPAHR,
+				ehrpwm_hr_cmpahr(ehrpwm, p, upd[i].duty_frac));
+		}
+		ehrpwm_write(ehrpwm, chan ? CMPB : CMPA,
+				upd[i].duty_ticks / ehrpwm->prescale_val);
+	}
+
+	for (i = n; i-- > 0; )
+		if (!ehrpwm_sync_seen(upd, i))
+			spin_unlock(&to_ehrpwm_pwm(upd[i].p)->lock);
+	spin_unlock_irqrestore(&ehrpwm_sync_lock, flags);
+
+	for (i = 0; i < n; i++)
+		pm_runtime_put_sync(to_ehrpwm_pwm(upd[i].p)->dev);
+
+	for (i = 0; i < n; i++) {
+		p = upd[i].p;
+		ehrpwm = to_ehrpwm_pwm(p);
+		chan = p - &ehrpwm->pwm[0];
+
+		if (upd[i].period_ticks) {
+			p->period_ticks = upd[i].period_ticks;
+			p->period_ns = pwm_ticks_to_ns(p, p->period_ticks);
+			ehrpwm->pwm[!chan].period_ticks = p->period_ticks;
+			ehrpwm->pwm[!chan].period_ns = p->period_ns;
+		}
+		p->duty_ticks = upd[i].duty_ticks;
+		p->duty_ns = pwm_ticks_to_ns(p, p->duty_ticks);
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL(ehrpwm_sync_update);
+
 int ehrpwm_et_cb_register(struct pwm_device *p, void *data,
 	p_fcallback cb)
 {
@@ -1324,6 +1617,7 @@ static int ehrpwm_freq_transition_cb(struct pwm_device *p)
 	unsigned long duty_ns;
 
 	p->tick_hz = clk_get_rate(ehrpwm->clk);
+	ehrpwm->mep_sf = 0;
 	duty_ns = p->duty_ns;
 	if (pwm_is_running(p)) {
 		pwm_stop(p);
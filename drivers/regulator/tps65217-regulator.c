@@ -257,8 +257,23 @@ static int tps65217_pmic_dcdc_get_voltage_sel(struct regulator_dev *dev)
 	return selector;
 }
 
-static int tps65217_pmic_dcdc_set_voltage(struct regulator_dev *dev,
-				  int min_uV, int max_uV, unsigned *selector)
+/*
+ * The DCDCs share one selector table, but each of them only supports the
+ * part of it within its own min_uV..max_uV.
+ */
+static bool tps65217_dcdc_sel_valid(struct tps_info *info, unsigned selector)
+{
+	int uV;
+
+	if (selector >= info->table_len)
+		return false;
+
+	uV = info->vsel_to_uv(selector);
+	return uV >= info->min_uV && uV <= info->max_uV;
+}
+
+static int tps65217_pmic_dcdc_set_voltage_sel(struct regulator_dev *dev,
+						unsigned selector)
 {
 	int ret;
 	struct tps65217 *tps = rdev_get_drvdata(dev);
@@ -267,22 +282,13 @@ static int tps65217_pmic_dcdc_set_voltage(struct regulator_dev *dev,
 	if (dcdc < TPS65217_DCDC_1 || dcdc > TPS65217_DCDC_3)
 		return -EINVAL;
 
-	if (min_uV < tps->info[dcdc]->min_uV
-		|| min_uV > tps->info[dcdc]->max_uV)
+	if (!tps65217_dcdc_sel_valid(tps->info[dcdc], selector))
 		return -EINVAL;
 
-	if (max_uV < tps->info[dcdc]->min_uV
-		|| max_uV > tps->info[dcdc]->max_uV)
-		return -EINVAL;
-
-	ret = tps->info[dcdc]->uv_to_vsel(min_uV, selector);
-	if (ret)
-		return ret;
-
 	/* Set the voltage based on vsel value and write protect level is 2 */
 	ret = tps65217_set_bits(tps, tps->info[dcdc]->set_vout_reg,
 					tps->info[dcdc]->set_vout_mask,
-					*selector, TPS65217_PROTECT_L2);
+					selector, TPS65217_PROTECT_L2);
 	if (ret)
 		return ret;
 
@@ -292,6 +298,38 @@ static int tps65217_pmic_dcdc_set_voltage(struct regulator_dev *dev,
 				TPS65217_PROTECT_L2);
 }
 
+/* DCDC ramp time per 25 mV step in ns, indexed by DEFSLEW.SLEW */
+static const unsigned int tps65217_dcdc_slew_ns[] = {
+	224000, 112000, 56000, 28000, 14000, 7000, 3500, 0,
+};
+
+static int tps65217_pmic_dcdc_set_voltage_time_sel(struct regulator_dev *dev,
+				unsigned int old_selector,
+				unsigned int new_selector)
+{
+	struct tps65217 *tps = rdev_get_drvdata(dev);
+	unsigned int dcdc = rdev_get_id(dev);
+	int old_uV, new_uV, ret;
+	unsigned int slew;
+
+	if (dcdc < TPS65217_DCDC_1 || dcdc > TPS65217_DCDC_3)
+		return -EINVAL;
+
+	ret = tps65217_reg_read(tps, TPS65217_REG_DEFSLEW, &slew);
+	if (ret)
+		return ret;
+	slew &= TPS65217_DEFSLEW_SLEW_MASK;
+
+	old_uV = tps->info[dcdc]->vsel_to_uv(old_selector);
+	new_uV = tps->info[dcdc]->vsel_to_uv(new_selector);
+	if (old_uV < 0 || new_uV < 0)
+		return -EINVAL;
+
+	/* the output moves in 25 mV steps */
+	return DIV_ROUND_UP(DIV_ROUND_UP(abs(new_uV - old_uV), 25000) *
+			    tps65217_dcdc_slew_ns[slew], 1000);
+}
+
 static int tps65217_pmic_ldo_get_voltage_sel(struct regulator_dev *dev)
 {
 	int ret;
@@ -368,6 +406,10 @@ static int tps65217_pmic_dcdc_list_voltage(struct regulator_dev *dev,
 	if (selector >= tps->info[dcdc]->table_len)
 		return -EINVAL;
 
+	/* out of this DCDC's range: the core must not pick it */
+	if (!tps65217_dcdc_sel_valid(tps->info[dcdc], selector))
+		return 0;
+
 	return tps->info[dcdc]->vsel_to_uv(selector);
 }
 
@@ -395,7 +437,8 @@ static struct regulator_ops tps65217_pmic_dcdc_ops = {
 	.enable			= tps65217_pmic_dcdc_enable,
 	.disable		= tps65217_pmic_dcdc_disable,
 	.get_voltage_sel	= tps65217_pmic_dcdc_get_voltage_sel,
-	.set_voltage		= tps65217_pmic_dcdc_set_voltage,
+	.set_voltage_sel	= tps65217_pmic_dcdc_set_voltage_sel,
+	.set_voltage_time_sel	= tps65217_pmic_dcdc_set_voltage_time_sel,
 	.list_voltage		= tps65217_pmic_dcdc_list_voltage,
 };
 
@@ -6,7 +6,8 @@
  *
  * Zcache provides an in-kernel "host implementation" for transcendent memory
  * and, thus indirectly, for cleancache and frontswap.  Zcache includes two
- * page-accessible memory [1] interfaces, both utilizing lzo1x compression:
+ * page-accessible memory [1] interfaces, both utilizing compression through
+ * the crypto API (lzo by default, see the zcache= boot parameter):
  * 1) "compression buddies" ("zbud") is used for ephemeral pages
  * 2) xvmalloc is used for persistent pages.
  * Xvmalloc (based on the TLSF allocator) has very low fragmentation
@@ -23,7 +24,8 @@
 #include <linux/cpu.h>
 #include <linux/highmem.h>
 #include <linux/list.h>
-#include <linux/lzo.h>
+#include <linux/crypto.h>
+#include <linux/string.h>
 #include <linux/slab.h>
 #include <linux/spinlock.h>
 #include <linux/types.h>
@@ -58,6 +60,39 @@
 
 MODULE_LICENSE("GPL");
 
+/*
+ * Compression goes through the crypto API, with one transform per cpu.
+ * Callers run with preemption or interrupts disabled.
+ */
+static char zcache_comp_name[CRYPTO_MAX_ALG_NAME];
+static struct crypto_comp * __percpu *zcache_comp_pcpu_tfms;
+
+enum zcache_comp_op {
+	ZCACHE_COMPOP_COMPRESS,
+	ZCACHE_COMPOP_DECOMPRESS,
+};
+
+static int zcache_comp_op(enum zcache_comp_op op, const u8 *src,
+			  unsigned int slen, u8 *dst, unsigned int *dlen)
+{
+	struct crypto_comp *tfm;
+	int ret;
+
+	tfm = *per_cpu_ptr(zcache_comp_pcpu_tfms, get_cpu());
+	if (unlikely(!tfm)) {
+		put_cpu();
+		return -ENODEV;
+	}
+
+	if (op == ZCACHE_COMPOP_COMPRESS)
+		ret = crypto_comp_compress(tfm, src, slen, dst, dlen);
+	else
+		ret = crypto_comp_decompress(tfm, src, slen, dst, dlen);
+	put_cpu();
+
+	return ret;
+}
+
 struct zcache_client {
 	struct tmem_pool *tmem_pools[MAX_POOLS_PER_CLIENT];
 	struct xv_pool *xvpool;
@@ -407,7 +442,7 @@ static int zbud_decompress(struct page *page, struct zbud_hdr *zh)
 {
 	struct zbud_page *zbpg;
 	unsigned budnum = zbud_budnum(zh);
-	size_t out_len = PAGE_SIZE;
+	unsigned int out_len = PAGE_SIZE;
 	char *to_va, *from_va;
 	unsigned size;
 	int ret = 0;
@@ -424,10 +459,15 @@ static int zbud_decompress(struct page *page, struct zbud_hdr *zh)
 	to_va = kmap_atomic(page, KM_USER0);
 	size = zh->size;
 	from_va = zbud_data(zh, size);
-	ret = lzo1x_decompress_safe(from_va, size, to_va, &out_len);
-	BUG_ON(ret != LZO_E_OK);
-	BUG_ON(out_len != PAGE_SIZE);
+	ret = zcache_comp_op(ZCACHE_COMPOP_DECOMPRESS, from_va, size,
+				to_va, &out_len);
 	kunmap_atomic(to_va, KM_USER0);
+	if (unlikely(ret)) {
+		/* no tfm on this cpu; distinct from the zombie -EINVAL */
+		ret = -EIO;
+		goto out;
+	}
+	BUG_ON(out_len != PAGE_SIZE);
 out:
 	spin_unlock(&zbpg->lock);
 	return ret;
@@ -708,9 +748,9 @@ static void zv_free(struct xv_pool *xvpool, struct zv_hdr *zv)
 	local_irq_restore(flags);
 }
 
-static void zv_decompress(struct page *page, struct zv_hdr *zv)
+static int zv_decompress(struct page *page, struct zv_hdr *zv)
 {
-	size_t clen = PAGE_SIZE;
+	unsigned int clen = PAGE_SIZE;
 	char *to_va;
 	unsigned size;
 	int ret;
@@ -719,11 +759,13 @@ static void zv_decompress(struct page *page, struct zv_hdr *zv)
 	size = xv_get_object_size(zv) - sizeof(*zv);
 	BUG_ON(size == 0);
 	to_va = kmap_atomic(page, KM_USER0);
-	ret = lzo1x_decompress_safe((char *)zv + sizeof(*zv),
-					size, to_va, &clen);
+	ret = zcache_comp_op(ZCACHE_COMPOP_DECOMPRESS, (char *)zv + sizeof(*zv),
+				size, to_va, &clen);
 	kunmap_atomic(to_va, KM_USER0);
-	BUG_ON(ret != LZO_E_OK);
+	if (unlikely(ret))
+		return -EIO;
 	BUG_ON(clen != PAGE_SIZE);
+	return 0;
 }
 
 #ifdef CONFIG_SYSFS
@@ -1208,11 +1250,8 @@ static int zcache_pampd_get_data(char *data, size_t *bufsize, bool raw,
 					void *pampd, struct tmem_pool *pool,
 					struct tmem_oid *oid, uint32_t index)
 {
-	int ret = 0;
-
 	BUG_ON(is_ephemeral(pool));
-	zv_decompress((struct page *)(data), pampd);
-	return ret;
+	return zv_decompress((struct page *)(data), pampd);
 }
 
 /*
@@ -1223,12 +1262,16 @@ static int zcache_pampd_get_data_and_free(char *data, size_t *bufsize, bool raw,
 					void *pampd, struct tmem_pool *pool,
 					struct tmem_oid *oid, uint32_t index)
 {
+	int ret;
+
 	BUG_ON(!is_ephemeral(pool));
-	if (zbud_decompress((struct page *)(data), pampd) < 0)
-		return -EINVAL;
+	ret = zbud_decompress((struct page *)(data), pampd);
+	if (ret == -EINVAL)
+		return ret;
+	/* pampd is already unlinked from tmem, so free it even on -EIO */
 	zbud_free_and_delist((struct zbud_hdr *)pampd);
 	atomic_dec(&zcache_curr_eph_pampd_count);
-	return 0;
+	return ret;
 }
 
 /*
@@ -1284,27 +1327,30 @@ static struct tmem_pamops zcache_pamops = {
  * zcache compression/decompression and related per-cpu stuff
  */
 
-#define LZO_WORKMEM_BYTES LZO1X_1_MEM_COMPRESS
-#define LZO_DSTMEM_PAGE_ORDER 1
-static DEFINE_PER_CPU(unsigned char *, zcache_workmem);
+#define ZCACHE_DSTMEM_ORDER 1
 static DEFINE_PER_CPU(unsigned char *, zcache_dstmem);
 
 static int zcache_compress(struct page *from, void **out_va, size_t *out_len)
 {
 	int ret = 0;
 	unsigned char *dmem = __get_cpu_var(zcache_dstmem);
-	unsigned char *wmem = __get_cpu_var(zcache_workmem);
+	unsigned int clen = PAGE_SIZE << ZCACHE_DSTMEM_ORDER;
 	char *from_va;
 
 	BUG_ON(!irqs_disabled());
-	if (unlikely(dmem == NULL || wmem == NULL))
+	if (unlikely(dmem == NULL))
 		goto out;  /* no buffer, so can't compress */
 	from_va = kmap_atomic(from, KM_USER0);
 	mb();
-	ret = lzo1x_1_compress(from_va, PAGE_SIZE, dmem, out_len, wmem);
-	BUG_ON(ret != LZO_E_OK);
-	*out_va = dmem;
+	ret = zcache_comp_op(ZCACHE_COMPOP_COMPRESS, from_va, PAGE_SIZE,
+				dmem, &clen);
 	kunmap_atomic(from_va, KM_USER0);
+	if (unlikely(ret)) {
+		ret = 0;
+		goto out;  /* no tfm on this cpu, so can't compress */
+	}
+	*out_len = clen;
+	*out_va = dmem;
 	ret = 1;
 out:
 	return ret;
@@ -1316,23 +1362,24 @@ static int zcache_cpu_notifier(struct notifier_block *nb,
 {
 	int cpu = (long)pcpu;
 	struct zcache_preload *kp;
+	struct crypto_comp *tfm;
 
 	switch (action) {
 	case CPU_UP_PREPARE:
+		tfm = crypto_alloc_comp(zcache_comp_name, 0, 0);
+		*per_cpu_ptr(zcache_comp_pcpu_tfms, cpu) =
+			IS_ERR(tfm) ? NULL : tfm;
 		per_cpu(zcache_dstmem, cpu) = (void *)__get_free_pages(
 			GFP_KERNEL | __GFP_REPEAT,
-			LZO_DSTMEM_PAGE_ORDER),
-		per_cpu(zcache_workmem, cpu) =
-			kzalloc(LZO1X_MEM_COMPRESS,
-				GFP_KERNEL | __GFP_REPEAT);
+			ZCACHE_DSTMEM_ORDER);
 		break;
 	case CPU_DEAD:
 	case CPU_UP_CANCELED:
+		crypto_free_comp(*per_cpu_ptr(zcache_comp_pcpu_tfms, cpu));
+		*per_cpu_ptr(zcache_comp_pcpu_tfms, cpu) = NULL;
 		free_pages((unsigned long)per_cpu(zcache_dstmem, cpu),
-				LZO_DSTMEM_PAGE_ORDER);
+				ZCACHE_DSTMEM_ORDER);
 		per_cpu(zcache_dstmem, cpu) = NULL;
-		kfree(per_cpu(zcache_workmem, cpu));
-		per_cpu(zcache_workmem, cpu) = NULL;
 		kp = &per_cpu(zcache_preloads, cpu);
 		while (kp->nr) {
 			kmem_cache_free(zcache_objnode_cache,
@@ -1888,13 +1935,37 @@ struct frontswap_ops zcache_frontswap_register_ops(void)
 
 static int zcache_enabled;
 
+/* "zcache" enables zcache with lzo, "zcache=<alg>" picks the compressor */
 static int __init enable_zcache(char *s)
 {
+	if (*s == '=')
+		strlcpy(zcache_comp_name, s + 1, sizeof(zcache_comp_name));
+	else if (*s)
+		return 0;
 	zcache_enabled = 1;
 	return 1;
 }
 __setup("zcache", enable_zcache);
 
+static int __init zcache_comp_init(void)
+{
+	if (*zcache_comp_name && !crypto_has_comp(zcache_comp_name, 0, 0)) {
+		pr_info("zcache: %s not supported, using lzo\n",
+			zcache_comp_name);
+		*zcache_comp_name = '\0';
+	}
+	if (!*zcache_comp_name)
+		strcpy(zcache_comp_name, "lzo");
+	if (!crypto_has_comp(zcache_comp_name, 0, 0))
+		return -ENODEV;
+	pr_info("zcache: using %s compressor\n", zcache_comp_name);
+
+	zcache_comp_pcpu_tfms = alloc_percpu(struct crypto_comp *);
+	if (!zcache_comp_pcpu_tfms)
+		return -ENOMEM;
+	return 0;
+}
+
 /* allow independent dynamic disabling of cleancache and frontswap */
 
 static int use_cleancache = 1;
@@ -1932,6 +2003,11 @@ static int __init zcache_init(void)
 	if (zcache_enabled) {
 		unsigned int cpu;
 
+		ret = zcache_comp_init();
+		if (ret) {
+			pr_err("zcache: compressor initialization failed\n");
+			goto out;
+		}
 		tmem_register_hostops(&zcache_hostops);
 		tmem_register_pamops(&zcache_pamops);
 		ret = register_cpu_notifier(&zcache_cpu_notifier_block);
@@ -0,0 +1,531 @@
+/*
+ * Compression streams for zram
+ *
+ * This code is released using a dual license strategy: BSD/GPL
+ * You can choose the licence that better fits your requirements.
+ *
+ * Released under the terms of 3-clause BSD License
+ * Released under the terms of GNU General Public License Version 2.0
+ */
+
+#include <linux/kernel.h>
+#include <linux/err.h>
+#include <linux/string.h>
+#include <linux/slab.h>
+#include <linux/sched.h>
+#include <linux/percpu.h>
+#include <linux/vmalloc.h>
+#include <linux/lzo.h>
+#include <linux/lz4.h>
+#include <linux/zlib.h>
+
+#include "zcomp.h"
+
+static void *lzo_create(gfp_t flags)
+{
+	return kzalloc(LZO1X_MEM_COMPRESS, flags);
+}
+
+static void lzo_destroy(void *private)
+{
+	kfree(private);
+}
+
+static int lzo_compress(const unsigned char *src, unsigned char *dst,
+			size_t *dst_len, void *private)
+{
+	int ret = lzo1x_1_compress(src, PAGE_SIZE, dst, dst_len, private);
+
+	return ret == LZO_E_OK ? 0 : ret;
+}
+
+static int lzo_decompress(const unsigned char *src, size_t src_len,
+			  unsigned char *dst, void *private)
+{
+	size_t dst_len = PAGE_SIZE;
+	int ret = lzo1x_decompress_safe(src, src_len, dst, &dst_len);
+
+	return ret == LZO_E_OK ? 0 : ret;
+}
+
+static struct zcomp_backend zcomp_lzo = {
+	.name		= "lzo",
+	.compress	= lzo_compress,
+	.decompress	= lzo_decompress,
+	.create		= lzo_create,
+	.destroy	= lzo_destroy,
+};
+
+static void *lz4_create(gfp_t flags)
+{
+	return kzalloc(LZ4_MEM_COMPRESS, flags);
+}
+
+static void lz4_destroy(void *private)
+{
+	kfree(private);
+}
+
+static int lz4_compress_page(const unsigned char *src, unsigned char *dst,
+			     size_t *dst_len, void *private)
+{
+	return lz4_compress(src, PAGE_SIZE, dst, dst_len, private);
+}
+
+static int lz4_decompress_page(const unsigned char *src, size_t src_len,
+			       unsigned char *dst, void *private)
+{
+	size_t dst_len = PAGE_SIZE;
+
+	return lz4_decompress_safe(src, src_len, dst, &dst_len);
+}
+
+static struct zcomp_backend zcomp_lz4 = {
+	.name		= "lz4",
+	.compress	= lz4_compress_page,
+	.decompress	= lz4_decompress_page,
+	.create		= lz4_create,
+	.destroy	= lz4_destroy,
+};
+
+#ifdef CONFIG_ZRAM_DEFLATE
+/*
+ * Raw deflate with a window just large enough for one page.  memLevel 6
+ * keeps the compression workspace near 48K per stream; the default of 8
+ * would quadruple it for no gain on 4K inputs.
+ */
+#define ZCOMP_DEFLATE_WINBITS	12
+#define ZCOMP_DEFLATE_MEMLEVEL	6
+
+static void deflate_destroy(void *private)
+{
+	struct z_stream_s *stream = private;
+
+	zlib_deflateEnd(stream);
+	vfree(stream->workspace);
+	kfree(stream);
+}
+
+static void *deflate_create(gfp_t flags)
+{
+	struct z_stream_s *stream;
+
+	stream = kzalloc(sizeof(*stream), flags);
+	if (!stream)
+		return NULL;
+
+	stream->workspace = __vmalloc(zlib_deflate_workspacesize(
+					-ZCOMP_DEFLATE_WINBITS,
+					ZCOMP_DEFLATE_MEMLEVEL),
+				flags | __GFP_HIGHMEM | __GFP_ZERO, PAGE_KERNEL);
+	if (!stream->workspace)
+		goto fail;
+
+	if (zlib_deflateInit2(stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+			      -ZCOMP_DEFLATE_WINBITS, ZCOMP_DEFLATE_MEMLEVEL,
+			      Z_DEFAULT_STRATEGY) != Z_OK) {
+		vfree(stream->workspace);
+		goto fail;
+	}
+	return stream;
+
+fail:
+	kfree(stream);
+	return NULL;
+}
+
+static int deflate_compress(const unsigned char *src, unsigned char *dst,
+			    size_t *dst_len, void *private)
+{
+	struct z_stream_s *stream = private;
+
+	if (zlib_deflateReset(stream) != Z_OK)
+		return -EINVAL;
+
+	stream->next_in = src;
+	stream->avail_in = PAGE_SIZE;
+	stream->next_out = dst;
+	stream->avail_out = 2 * PAGE_SIZE;
+
+	if (zlib_deflate(stream, Z_FINISH) != Z_STREAM_END)
+		return -EINVAL;
+
+	*dst_len = stream->total_out;
+	return 0;
+}
+
+static void *inflate_create(void)
+{
+	struct z_stream_s *stream;
+
+	stream = kzalloc(sizeof(*stream), GFP_KERNEL);
+	if (!stream)
+		return NULL;
+
+	stream->workspace = vzalloc(zlib_inflate_workspacesize());
+	if (!stream->workspace ||
+	    zlib_inflateInit2(stream, -ZCOMP_DEFLATE_WINBITS) != Z_OK) {
+		vfree(stream->workspace);
+		kfree(stream);
+		return NULL;
+	}
+	return stream;
+}
+
+static void inflate_destroy(void *private)
+{
+	struct z_stream_s *stream = private;
+
+	zlib_inflateEnd(stream);
+	vfree(stream->workspace);
+	kfree(stream);
+}
+
+static int deflate_decompress(const unsigned char *src, size_t src_len,
+			      unsigned char *dst, void *private)
+{
+	struct z_stream_s *stream = private;
+	int ret;
+
+	if (zlib_inflateReset(stream) != Z_OK)
+		return -EINVAL;
+
+	stream->next_in = src;
+	stream->avail_in = src_len;
+	stream->next_out = dst;
+	stream->avail_out = PAGE_SIZE;
+
+	/* Raw inflate may want one byte past the end, see crypto/deflate.c */
+	ret = zlib_inflate(stream, Z_SYNC_FLUSH);
+	if (ret == Z_OK && !stream->avail_in && stream->avail_out) {
+		u8 zerostuff = 0;
+
+		stream->next_in = &zerostuff;
+		stream->avail_in = 1;
+		ret = zlib_inflate(stream, Z_FINISH);
+	}
+
+	return ret == Z_STREAM_END ? 0 : -EINVAL;
+}
+
+static struct zcomp_backend zcomp_deflate = {
+	.name		= "deflate",
+	.compress	= deflate_compress,
+	.decompress	= deflate_decompress,
+	.create		= deflate_create,
+	.destroy	= deflate_destroy,
+	.create_decomp	= inflate_create,
+	.destroy_decomp	= inflate_destroy,
+};
+#endif
+
+static struct zcomp_backend *backends[] = {
+	&zcomp_lzo,
+	&zcomp_lz4,
+#ifdef CONFIG_ZRAM_DEFLATE
+	&zcomp_deflate,
+#endif
+};
+
+static struct zcomp_backend *find_backend(const char *name)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(backends); i++)
+		if (sysfs_streq(name, backends[i]->name))
+			return backends[i];
+	return NULL;
+}
+
+bool zcomp_available(const char *name)
+{
+	return find_backend(name) != NULL;
+}
+
+/* Lists the backends, the selected one in brackets */
+ssize_t zcomp_available_show(const char *selected, char *buf, size_t len)
+{
+	ssize_t sz = 0;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(backends); i++) {
+		const char *name = backends[i]->name;
+
+		if (!strcmp(selected, name))
+			sz += scnprintf(buf + sz, len - sz, "[%s] ", name);
+		else
+			sz += scnprintf(buf + sz, len - sz, "%s ", name);
+	}
+	sz += scnprintf(buf + sz, len - sz, "\n");
+	return sz;
+}
+
+static void zcomp_strm_free(struct zcomp *comp, struct zcomp_strm *zstrm)
+{
+	if (zstrm->private)
+		comp->backend->destroy(zstrm->private);
+	free_pages((unsigned long)zstrm->buffer, 1);
+	kfree(zstrm);
+}
+
+/*
+ * Streams are allocated on demand from the write path, i.e. possibly
+ * while swapping out, so the allocation must not recurse into I/O.
+ */
+static struct zcomp_strm *zcomp_strm_alloc(struct zcomp *comp, gfp_t flags)
+{
+	struct zcomp_strm *zstrm;
+
+	zstrm = kzalloc(sizeof(*zstrm), flags);
+	if (!zstrm)
+		return NULL;
+
+	zstrm->private = comp->backend->create(flags);
+	/* Worst case output of every backend is slightly more than a page */
+	zstrm->buffer = (void *)__get_free_pages(flags | __GFP_ZERO, 1);
+	if (!zstrm->private || !zstrm->buffer) {
+		zcomp_strm_free(comp, zstrm);
+		return NULL;
+	}
+	return zstrm;
+}
+
+/**
+ * zcomp_strm_find - get an idle compression stream
+ * @comp: stream pool
+ *
+ * Creates a new stream while fewer than max_strm exist, otherwise
+ * sleeps until another writer releases one.  Always succeeds once the
+ * pool holds at least one stream, which zcomp_create() guarantees.
+ */
+struct zcomp_strm *zcomp_strm_find(struct zcomp *comp)
+{
+	struct zcomp_strm *zstrm;
+	int id;
+
+	while (1) {
+		spin_lock(&comp->strm_lock);
+		if (!list_empty(&comp->idle_strm)) {
+			zstrm = list_first_entry(&comp->idle_strm,
+						 struct zcomp_strm, list);
+			list_del(&zstrm->list);
+			spin_unlock(&comp->strm_lock);
+			return zstrm;
+		}
+
+		if (comp->avail_strm >= comp->max_strm) {
+			spin_unlock(&comp->strm_lock);
+			wait_event(comp->strm_wait,
+				   !list_empty(&comp->idle_strm));
+			continue;
+		}
+
+		/* Reserve a slot, then allocate without the lock */
+		for (id = 0; comp->strm[id]; id++)
+			;
+		comp->strm[id] = ERR_PTR(-EBUSY);
+		comp->avail_strm++;
+		spin_unlock(&comp->strm_lock);
+
+		zstrm = zcomp_strm_alloc(comp, GFP_NOIO);
+		spin_lock(&comp->strm_lock);
+		if (zstrm) {
+			zstrm->id = id;
+			comp->strm[id] = zstrm;
+			spin_unlock(&comp->strm_lock);
+			return zstrm;
+		}
+		comp->strm[id] = NULL;
+		comp->avail_strm--;
+		spin_unlock(&comp->strm_lock);
+
+		/* Out of memory: wait for one of the existing streams */
+		wait_event(comp->strm_wait, !list_empty(&comp->idle_strm));
+	}
+}
+
+void zcomp_strm_release(struct zcomp *comp, struct zcomp_strm *zstrm)
+{
+	spin_lock(&comp->strm_lock);
+	list_add(&zstrm->list, &comp->idle_strm);
+	spin_unlock(&comp->strm_lock);
+
+	wake_up(&comp->strm_wait);
+}
+
+/**
+ * zcomp_compress - compress one page into the stream's buffer
+ * @comp: stream pool
+ * @zstrm: stream from zcomp_strm_find()
+ * @src: page to compress
+ * @dst_len: set to the compressed size
+ */
+int zcomp_compress(struct zcomp *comp, struct zcomp_strm *zstrm,
+		   const unsigned char *src, size_t *dst_len)
+{
+	u64 start = sched_clock();
+	int ret;
+
+	ret = comp->backend->compress(src, zstrm->buffer, dst_len,
+				      zstrm->private);
+	if (!ret) {
+		zstrm->nr_comp++;
+		zstrm->comp_ns += sched_clock() - start;
+		zstrm->in_bytes += PAGE_SIZE;
+		zstrm->out_bytes += *dst_len;
+	}
+	return ret;
+}
+
+/*
+ * Decompression needs no stream; backends that need working memory get
+ * a per-cpu one, so this never sleeps.
+ */
+int zcomp_decompress(struct zcomp *comp, const unsigned char *src,
+		     size_t src_len, unsigned char *dst)
+{
+	void *private = NULL;
+	int ret;
+
+	if (!comp->decomp_private)
+		return comp->backend->decompress(src, src_len, dst, NULL);
+
+	private = *get_cpu_ptr(comp->decomp_private);
+	ret = comp->backend->decompress(src, src_len, dst, private);
+	put_cpu_ptr(comp->decomp_private);
+
+	return ret;
+}
+
+static void zcomp_decomp_free(struct zcomp *comp)
+{
+	int cpu;
+
+	if (!comp->decomp_private)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		void *private = *per_cpu_ptr(comp->decomp_private, cpu);
+
+		if (private)
+			comp->backend->destroy_decomp(private);
+	}
+	free_percpu(comp->decomp_private);
+}
+
+static int zcomp_decomp_alloc(struct zcomp *comp)
+{
+	int cpu;
+
+	if (!comp->backend->create_decomp)
+		return 0;
+
+	comp->decomp_private = alloc_percpu(void *);
+	if (!comp->decomp_private)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		void *private = comp->backend->create_decomp();
+
+		if (!private)
+			return -ENOMEM;
+		*per_cpu_ptr(comp->decomp_private, cpu) = private;
+	}
+	return 0;
+}
+
+/*
+ * One line per stream: id, pages, average ns per page and compressed
+ * size as a percentage of the input.
+ */
+ssize_t zcomp_strm_stats(struct zcomp *comp, char *buf, size_t len)
+{
+	ssize_t sz = 0;
+	int i;
+
+	sz += scnprintf(buf + sz, len - sz,
+			"%-6s %12s %10s %8s\n", "stream", "pages", "avg_ns",
+			"ratio%");
+
+	for (i = 0; i < comp->max_strm; i++) {
+		struct zcomp_strm *zstrm = comp->strm[i];
+		u64 avg = 0, ratio = 0;
+
+		if (IS_ERR_OR_NULL(zstrm))
+			continue;
+		if (zstrm->nr_comp)
+			avg = div64_u64(zstrm->comp_ns, zstrm->nr_comp);
+		if (zstrm->in_bytes)
+			ratio = div64_u64(zstrm->out_bytes * 100,
+					  zstrm->in_bytes);
+
+		sz += scnprintf(buf + sz, len - sz, "%-6d %12llu %10llu %8llu\n",
+				i, zstrm->nr_comp, avg, ratio);
+	}
+	return sz;
+}
+
+/**
+ * zcomp_create - create a compression stream pool
+ * @name: backend name, one of those zcomp_available() accepts
+ * @max_strm: maximum number of concurrent streams
+ *
+ * One stream is allocated up front so that zcomp_strm_find() can
+ * always make progress under memory pressure.
+ */
+struct zcomp *zcomp_create(const char *name, int max_strm)
+{
+	struct zcomp_backend *backend = find_backend(name);
+	struct zcomp *comp;
+	struct zcomp_strm *zstrm;
+
+	if (!backend)
+		return NULL;
+	if (max_strm < 1)
+		max_strm = 1;
+
+	comp = kzalloc(sizeof(*comp), GFP_KERNEL);
+	if (!comp)
+		return NULL;
+
+	comp->strm = kcalloc(max_strm, sizeof(*comp->strm), GFP_KERNEL);
+	if (!comp->strm)
+		goto fail;
+
+	comp->backend = backend;
+	comp->max_strm = max_strm;
+	spin_lock_init(&comp->strm_lock);
+	INIT_LIST_HEAD(&comp->idle_strm);
+	init_waitqueue_head(&comp->strm_wait);
+
+	if (zcomp_decomp_alloc(comp))
+		goto fail;
+
+	zstrm = zcomp_strm_alloc(comp, GFP_KERNEL);
+	if (!zstrm)
+		goto fail;
+
+	comp->strm[0] = zstrm;
+	comp->avail_strm = 1;
+	list_add(&zstrm->list, &comp->idle_strm);
+	return comp;
+
+fail:
+	zcomp_decomp_free(comp);
+	kfree(comp->strm);
+	kfree(comp);
+	return NULL;
+}
+
+/* Must only be called once every stream has been released */
+void zcomp_destroy(struct zcomp *comp)
+{
+	int i;
+
+	for (i = 0; i < comp->max_strm; i++)
+		if (comp->strm[i])
+			zcomp_strm_free(comp, comp->strm[i]);
+	zcomp_decomp_free(comp);
+	kfree(comp->strm);
+	kfree(comp);
+}
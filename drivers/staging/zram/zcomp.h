@@ -0,0 +1,82 @@
+/*
+ * Compression streams for zram
+ *
+ * This code is released using a dual license strategy: BSD/GPL
+ * You can choose the licence that better fits your requirements.
+ *
+ * Released under the terms of 3-clause BSD License
+ * Released under the terms of GNU General Public License Version 2.0
+ */
+
+#ifndef _ZCOMP_H_
+#define _ZCOMP_H_
+
+#include <linux/list.h>
+#include <linux/spinlock.h>
+#include <linux/wait.h>
+
+/*
+ * A compression stream is the working memory and output buffer one
+ * compression needs.  zram keeps a small pool of them so that writers
+ * on different CPUs compress in parallel instead of serializing on a
+ * single buffer.
+ */
+struct zcomp_strm {
+	void *buffer;		/* compressed output, 2 pages */
+	void *private;		/* backend working memory */
+	struct list_head list;	/* on zcomp->idle_strm while unused */
+	int id;
+
+	/* Updated by the stream's current owner only */
+	u64 nr_comp;		/* pages compressed */
+	u64 comp_ns;		/* time spent compressing */
+	u64 in_bytes;
+	u64 out_bytes;
+};
+
+/*
+ * A compression algorithm.  create() allocates the working memory of
+ * one stream, passed to compress().  Backends that also need memory to
+ * decompress provide create_decomp(); zcomp keeps one such workspace
+ * per cpu and passes it to decompress(), which gets NULL otherwise.
+ */
+struct zcomp_backend {
+	const char *name;
+	int (*compress)(const unsigned char *src, unsigned char *dst,
+			size_t *dst_len, void *private);
+	int (*decompress)(const unsigned char *src, size_t src_len,
+			  unsigned char *dst, void *private);
+	void *(*create)(gfp_t flags);
+	void (*destroy)(void *private);
+	void *(*create_decomp)(void);
+	void (*destroy_decomp)(void *private);
+};
+
+struct zcomp {
+	struct zcomp_backend *backend;
+	spinlock_t strm_lock;		/* protects idle_strm and avail_strm */
+	struct list_head idle_strm;
+	wait_queue_head_t strm_wait;
+	int max_strm;
+	int avail_strm;
+	struct zcomp_strm **strm;	/* all streams, for statistics */
+	void * __percpu *decomp_private;
+};
+
+bool zcomp_available(const char *name);
+ssize_t zcomp_available_show(const char *selected, char *buf, size_t len);
+
+struct zcomp *zcomp_create(const char *name, int max_strm);
+void zcomp_destroy(struct zcomp *comp);
+
+struct zcomp_strm *zcomp_strm_find(struct zcomp *comp);
+void zcomp_strm_release(struct zcomp *comp, struct zcomp_strm *zstrm);
+
+int zcomp_compress(struct zcomp *comp, struct zcomp_strm *zstrm,
+		   const unsigned char *src, size_t *dst_len);
+int zcomp_decompress(struct zcomp *comp, const unsigned char *src,
+		     size_t src_len, unsigned char *dst);
+
+ssize_t zcomp_strm_stats(struct zcomp *comp, char *buf, size_t len);
+
+#endif /* _ZCOMP_H_ */
@@ -18,7 +18,8 @@
 #include <linux/spinlock.h>
 #include <linux/mutex.h>
 
-#include "xvmalloc.h"
+#include "zsmalloc.h"
+#include "zcomp.h"
 
 /*
  * Some arbitrary value. This is just to catch
@@ -26,33 +27,25 @@
  */
 static const unsigned max_num_devices = 32;
 
-/*
- * Stored at beginning of each compressed object.
- *
- * It stores back-reference to table entry which points to this
- * object. This is required to support memory defragmentation.
- */
-struct zobj_header {
-#if 0
-	u32 table_idx;
-#endif
-};
-
 /*-- Configurable parameters */
 
 /* Default zram disk size: 25% of total RAM */
 static const unsigned default_disksize_perc_ram = 25;
 
+/* Default compression backend, see comp_algorithm in zram.txt */
+static const char default_compressor[] = "lzo";
+
 /*
  * Pages that compress to size greater than this are stored
- * uncompressed in memory.
+ * uncompressed in memory.  zsmalloc packs objects across page
+ * boundaries, so anything that saves an eighth of a page is worth
+ * keeping compressed.
  */
-static const size_t max_zpage_size = PAGE_SIZE / 4 * 3;
+static const size_t max_zpage_size = PAGE_SIZE / 8 * 7;
 
 /*
- * NOTE: max_zpage_size must be less than or equal to:
- *   XV_MAX_ALLOC_SIZE - sizeof(struct zobj_header)
- * otherwise, xv_malloc() would always return failure.
+ * NOTE: max_zpage_size must be less than or equal to ZS_MAX_ALLOC_SIZE,
+ * otherwise, zs_malloc() would always return failure.
  */
 
 /*-- End of configurable params */
@@ -74,6 +67,9 @@ enum zram_pageflags {
 	/* Page consists entirely of zeros */
 	ZRAM_ZERO,
 
+	/* Bit spinlock serializing all access to the slot */
+	ZRAM_ACCESS,
+
 	__NR_ZRAM_PAGEFLAGS,
 };
 
@@ -81,11 +77,12 @@ enum zram_pageflags {
 
 /* Allocated for each disk page */
 struct table {
-	struct page *page;
-	u16 offset;
+	/* zsmalloc handle, or the struct page of an uncompressed page */
+	unsigned long handle;
+	u16 size;	/* compressed object size */
 	u8 count;	/* object ref count (not yet used) */
-	u8 flags;
-} __attribute__((aligned(4)));
+	unsigned long flags;
+};
 
 struct zram_stats {
 	u64 compr_size;		/* compressed size of pages stored */
@@ -95,20 +92,17 @@ struct zram_stats {
 	u64 failed_writes;	/* can happen when memory is too low */
 	u64 invalid_io;		/* non-page-aligned I/O requests */
 	u64 notify_free;	/* no. of swap slot free notifications */
-	u32 pages_zero;		/* no. of zero filled pages */
-	u32 pages_stored;	/* no. of pages currently stored */
-	u32 good_compress;	/* % of pages with compression ratio<=50% */
-	u32 pages_expand;	/* % of incompressible pages */
+	atomic_t pages_zero;		/* no. of zero filled pages */
+	atomic_t pages_stored;		/* no. of pages currently stored */
+	atomic_t good_compress;		/* % of pages with compression ratio<=50% */
+	atomic_t pages_expand;		/* % of incompressible pages */
 };
 
 struct zram {
-	struct xv_pool *mem_pool;
-	void *compress_workmem;
-	void *compress_buffer;
-	struct table *table;
+	struct zs_pool *mem_pool;
+	struct zcomp *comp;
+	struct table *table;	/* each slot is locked by its ZRAM_ACCESS bit */
 	spinlock_t stat64_lock;	/* protect 64-bit stats */
-	struct rw_semaphore lock; /* protect compression buffers and table
-				   * against concurrent read and writes */
 	struct request_queue *queue;
 	struct gendisk *disk;
 	int init_done;
@@ -120,6 +114,10 @@ struct zram {
 	 */
 	u64 disksize;	/* bytes */
 
+	/* Concurrent compression streams, 0 for one per online CPU */
+	unsigned int max_comp_streams;
+	char compressor[16];
+
 	struct zram_stats stats;
 };
 
@@ -0,0 +1,790 @@
+/*
+ * zsmalloc memory allocator
+ *
+ * This code is released using a dual license strategy: BSD/GPL
+ * You can choose the licence that better fits your requirements.
+ *
+ * Released under the terms of 3-clause BSD License
+ * Released under the terms of GNU General Public License Version 2.0
+ */
+
+/*
+ * Objects are carved out of "zspages": groups of up to
+ * ZS_MAX_PAGES_PER_ZSPAGE order-0 (possibly highmem) pages which are
+ * treated as one linear area, so an object may straddle a page boundary
+ * and almost nothing is lost at the end of each page.  Each size class
+ * uses the zspage length that wastes the least space for its size.
+ *
+ * zs_malloc() returns a handle: the address of a word holding the
+ * object's location (pfn of the zspage's first page and object index)
+ * shifted left by one.  Bit 0 of that word is a bit spinlock pinning
+ * the object while it is mapped or being freed.  Every object starts
+ * with a back-pointer to its handle, so zs_compact() can move objects
+ * that are not pinned from sparse zspages into fuller ones and update
+ * their handles in place, then release the emptied zspages.
+ */
+
+#ifdef CONFIG_ZRAM_DEBUG
+#define DEBUG
+#endif
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/bitops.h>
+#include <linux/bit_spinlock.h>
+#include <linux/errno.h>
+#include <linux/highmem.h>
+#include <linux/init.h>
+#include <linux/list.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+
+#include "zsmalloc.h"
+
+#define ZS_MAX_PAGES_PER_ZSPAGE	4
+#define ZS_ALIGN		16
+#define ZS_MIN_ALLOC_SIZE	32
+#define ZS_MAX_CLASS_SIZE	PAGE_SIZE
+#define ZS_NR_CLASSES	\
+	((ZS_MAX_CLASS_SIZE - ZS_MIN_ALLOC_SIZE) / ZS_ALIGN + 1)
+#define ZS_MAX_OBJS_PER_ZSPAGE	\
+	(ZS_MAX_PAGES_PER_ZSPAGE * PAGE_SIZE / ZS_MIN_ALLOC_SIZE)
+
+/*
+ * Object location: pfn << OBJ_INDEX_BITS | index.  Stored shifted left
+ * by one in the handle, which leaves BITS_PER_LONG - 11 bits for the
+ * pfn: 8GB of RAM with 4K pages on 32-bit.
+ */
+#define OBJ_INDEX_BITS		10
+#define OBJ_INDEX_MASK		((1UL << OBJ_INDEX_BITS) - 1)
+#define OBJ_FREE_END		OBJ_INDEX_MASK
+
+#define HANDLE_PIN_BIT		0
+
+/* Set in the first word of allocated objects, clear in free ones */
+#define OBJ_ALLOCATED_TAG	1UL
+
+/*
+ * Partially used zspages are kept on one of two lists, so allocation
+ * can fill the fuller ones first and compaction can drain the emptier
+ * ones.  Completely empty zspages are freed right away.
+ */
+enum fullness_group {
+	ZS_ALMOST_FULL,
+	ZS_ALMOST_EMPTY,
+	ZS_FULL,
+	NR_FULLNESS_GROUPS,
+};
+
+struct size_class;
+
+struct zspage {
+	struct list_head list;
+	struct size_class *class;
+	unsigned int inuse;
+	unsigned int free_idx;	/* first free object, or OBJ_FREE_END */
+	enum fullness_group fullness;
+	struct page *pages[ZS_MAX_PAGES_PER_ZSPAGE];
+};
+
+struct size_class {
+	spinlock_t lock;
+	unsigned int size;		/* object size including header */
+	unsigned int pages_per_zspage;
+	unsigned int objs_per_zspage;
+	struct list_head fullness_list[NR_FULLNESS_GROUPS];
+	unsigned long nr_zspages;
+	unsigned long nr_objs;
+};
+
+/*
+ * Per-cpu state of the current mapping.  Objects that straddle a page
+ * boundary are copied through buf.
+ */
+struct zs_map_area {
+	char *buf;
+	void *vaddr;
+	struct zspage *zspage;
+	unsigned int off;
+	unsigned int size;
+	enum zs_mapmode mm;
+};
+
+struct zs_pool {
+	const char *name;
+	gfp_t flags;
+	atomic_long_t pages_allocated;
+	atomic_long_t pages_compacted;
+	struct zs_map_area __percpu *map_area;
+	struct size_class classes[ZS_NR_CLASSES];
+};
+
+static DEFINE_MUTEX(zs_cache_lock);
+static unsigned int zs_cache_users;
+static struct kmem_cache *zs_handle_cachep;
+static struct kmem_cache *zs_zspage_cachep;
+
+static int zs_get_caches(void)
+{
+	int ret = 0;
+
+	mutex_lock(&zs_cache_lock);
+	if (zs_cache_users++)
+		goto out;
+
+	zs_handle_cachep = kmem_cache_create("zs_handle",
+				sizeof(unsigned long), 0, 0, NULL);
+	zs_zspage_cachep = kmem_cache_create("zs_zspage",
+				sizeof(struct zspage), 0, 0, NULL);
+	if (!zs_handle_cachep || !zs_zspage_cachep) {
+		if (zs_handle_cachep)
+			kmem_cache_destroy(zs_handle_cachep);
+		if (zs_zspage_cachep)
+			kmem_cache_destroy(zs_zspage_cachep);
+		zs_cache_users--;
+		ret = -ENOMEM;
+	}
+out:
+	mutex_unlock(&zs_cache_lock);
+	return ret;
+}
+
+static void zs_put_caches(void)
+{
+	mutex_lock(&zs_cache_lock);
+	if (!--zs_cache_users) {
+		kmem_cache_destroy(zs_handle_cachep);
+		kmem_cache_destroy(zs_zspage_cachep);
+	}
+	mutex_unlock(&zs_cache_lock);
+}
+
+static unsigned int get_class_idx(size_t size)
+{
+	if (size <= ZS_MIN_ALLOC_SIZE)
+		return 0;
+	return DIV_ROUND_UP(size - ZS_MIN_ALLOC_SIZE, ZS_ALIGN);
+}
+
+/* Pick the zspage length that leaves the smallest unused tail */
+static unsigned int get_pages_per_zspage(unsigned int size)
+{
+	unsigned int i, best = 1, best_usedpc = 0;
+
+	for (i = 1; i <= ZS_MAX_PAGES_PER_ZSPAGE; i++) {
+		unsigned int zspage_size = i * PAGE_SIZE;
+		unsigned int usedpc;
+
+		usedpc = (zspage_size - zspage_size % size) * 100 / zspage_size;
+		if (usedpc > best_usedpc) {
+			best_usedpc = usedpc;
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+static unsigned long obj_location(struct zspage *zspage, unsigned int idx)
+{
+	return (page_to_pfn(zspage->pages[0]) << OBJ_INDEX_BITS) | idx;
+}
+
+static struct zspage *location_to_zspage(unsigned long loc, unsigned int *idx)
+{
+	struct page *page = pfn_to_page(loc >> OBJ_INDEX_BITS);
+
+	*idx = loc & OBJ_INDEX_MASK;
+	return (struct zspage *)page_private(page);
+}
+
+static unsigned long handle_location(unsigned long *handle)
+{
+	return *handle >> 1;
+}
+
+static void pin_handle(unsigned long *handle)
+{
+	bit_spin_lock(HANDLE_PIN_BIT, handle);
+}
+
+static int trypin_handle(unsigned long *handle)
+{
+	return bit_spin_trylock(HANDLE_PIN_BIT, handle);
+}
+
+static void unpin_handle(unsigned long *handle)
+{
+	bit_spin_unlock(HANDLE_PIN_BIT, handle);
+}
+
+/*
+ * The first word of an object never crosses a page: objects start at
+ * multiples of ZS_ALIGN.
+ */
+static unsigned long obj_head_read(struct zspage *zspage, unsigned int idx)
+{
+	unsigned int off = idx * zspage->class->size;
+	unsigned long *addr, val;
+
+	addr = kmap_atomic(zspage->pages[off >> PAGE_SHIFT]);
+	val = *(unsigned long *)((char *)addr + (off & ~PAGE_MASK));
+	kunmap_atomic(addr);
+
+	return val;
+}
+
+static void obj_head_write(struct zspage *zspage, unsigned int idx,
+			   unsigned long val)
+{
+	unsigned int off = idx * zspage->class->size;
+	unsigned long *addr;
+
+	addr = kmap_atomic(zspage->pages[off >> PAGE_SHIFT]);
+	*(unsigned long *)((char *)addr + (off & ~PAGE_MASK)) = val;
+	kunmap_atomic(addr);
+}
+
+static enum fullness_group get_fullness_group(struct zspage *zspage)
+{
+	unsigned int max = zspage->class->objs_per_zspage;
+
+	if (zspage->inuse == max)
+		return ZS_FULL;
+	if (zspage->inuse * 4 >= max * 3)
+		return ZS_ALMOST_FULL;
+	return ZS_ALMOST_EMPTY;
+}
+
+static void fix_fullness_group(struct size_class *class, struct zspage *zspage)
+{
+	enum fullness_group fg = get_fullness_group(zspage);
+
+	if (fg == zspage->fullness)
+		return;
+	list_move(&zspage->list, &class->fullness_list[fg]);
+	zspage->fullness = fg;
+}
+
+static void free_zspage(struct zspage *zspage)
+{
+	unsigned int i;
+
+	set_page_private(zspage->pages[0], 0);
+	for (i = 0; i < zspage->class->pages_per_zspage; i++)
+		__free_page(zspage->pages[i]);
+	kmem_cache_free(zs_zspage_cachep, zspage);
+}
+
+static struct zspage *alloc_zspage(struct size_class *class, gfp_t flags)
+{
+	struct zspage *zspage;
+	unsigned int i;
+
+	zspage = kmem_cache_zalloc(zs_zspage_cachep, flags & ~__GFP_HIGHMEM);
+	if (!zspage)
+		return NULL;
+
+	zspage->class = class;
+	for (i = 0; i < class->pages_per_zspage; i++) {
+		zspage->pages[i] = alloc_page(flags);
+		if (!zspage->pages[i])
+			goto fail;
+	}
+	set_page_private(zspage->pages[0], (unsigned long)zspage);
+
+	/* Chain all objects on the free list */
+	for (i = 0; i < class->objs_per_zspage; i++) {
+		unsigned int next = i + 1;
+
+		if (next == class->objs_per_zspage)
+			next = OBJ_FREE_END;
+		obj_head_write(zspage, i, next << 1);
+	}
+	zspage->free_idx = 0;
+	INIT_LIST_HEAD(&zspage->list);
+
+	return zspage;
+
+fail:
+	while (i--)
+		__free_page(zspage->pages[i]);
+	kmem_cache_free(zs_zspage_cachep, zspage);
+	return NULL;
+}
+
+/* Called with class->lock held, zspage must have a free object */
+static unsigned int obj_alloc(struct size_class *class, struct zspage *zspage,
+			      unsigned long *handle)
+{
+	unsigned int idx = zspage->free_idx;
+
+	zspage->free_idx = obj_head_read(zspage, idx) >> 1;
+	obj_head_write(zspage, idx, (unsigned long)handle | OBJ_ALLOCATED_TAG);
+	zspage->inuse++;
+	class->nr_objs++;
+	fix_fullness_group(class, zspage);
+
+	return idx;
+}
+
+/*
+ * Called with class->lock held.  Returns true if the zspage became
+ * empty; it is then off the lists and the caller must free it.
+ */
+static bool obj_free(struct size_class *class, struct zspage *zspage,
+		     unsigned int idx)
+{
+	obj_head_write(zspage, idx, zspage->free_idx << 1);
+	zspage->free_idx = idx;
+	zspage->inuse--;
+	class->nr_objs--;
+
+	if (!zspage->inuse) {
+		list_del(&zspage->list);
+		class->nr_zspages--;
+		return true;
+	}
+
+	fix_fullness_group(class, zspage);
+	return false;
+}
+
+/* Fill the fullest zspages first to keep the class dense */
+static struct zspage *find_alloc_zspage(struct size_class *class)
+{
+	int fg;
+
+	for (fg = ZS_ALMOST_FULL; fg <= ZS_ALMOST_EMPTY; fg++) {
+		struct list_head *head = &class->fullness_list[fg];
+
+		if (!list_empty(head))
+			return list_first_entry(head, struct zspage, list);
+	}
+
+	return NULL;
+}
+
+/**
+ * zs_malloc - allocate an object from the pool
+ * @pool: pool to allocate from
+ * @size: object size, at most ZS_MAX_ALLOC_SIZE
+ *
+ * May sleep if the pool's gfp flags allow it.  Returns a handle to be
+ * passed to zs_map_object() and zs_free(), or 0 on failure.
+ */
+unsigned long zs_malloc(struct zs_pool *pool, size_t size)
+{
+	struct size_class *class;
+	struct zspage *zspage;
+	unsigned long *handle;
+	unsigned int idx;
+
+	if (unlikely(!size || size > ZS_MAX_ALLOC_SIZE))
+		return 0;
+
+	handle = kmem_cache_alloc(zs_handle_cachep,
+				  pool->flags & ~__GFP_HIGHMEM);
+	if (!handle)
+		return 0;
+
+	class = &pool->classes[get_class_idx(size + ZS_HANDLE_SIZE)];
+
+	spin_lock(&class->lock);
+	zspage = find_alloc_zspage(class);
+	if (!zspage) {
+		spin_unlock(&class->lock);
+
+		zspage = alloc_zspage(class, pool->flags);
+		if (!zspage) {
+			kmem_cache_free(zs_handle_cachep, handle);
+			return 0;
+		}
+		atomic_long_add(class->pages_per_zspage,
+				&pool->pages_allocated);
+
+		spin_lock(&class->lock);
+		zspage->fullness = ZS_ALMOST_EMPTY;
+		list_add(&zspage->list,
+			 &class->fullness_list[ZS_ALMOST_EMPTY]);
+		class->nr_zspages++;
+	}
+
+	idx = obj_alloc(class, zspage, handle);
+	*handle = obj_location(zspage, idx) << 1;
+	spin_unlock(&class->lock);
+
+	return (unsigned long)handle;
+}
+EXPORT_SYMBOL_GPL(zs_malloc);
+
+void zs_free(struct zs_pool *pool, unsigned long handle)
+{
+	unsigned long *h = (unsigned long *)handle;
+	struct size_class *class;
+	struct zspage *zspage;
+	unsigned int idx;
+	bool empty;
+
+	if (unlikely(!handle))
+		return;
+
+	/* Keeps zs_compact() from moving the object under us */
+	pin_handle(h);
+	zspage = location_to_zspage(handle_location(h), &idx);
+	class = zspage->class;
+
+	spin_lock(&class->lock);
+	empty = obj_free(class, zspage, idx);
+	spin_unlock(&class->lock);
+	unpin_handle(h);
+
+	kmem_cache_free(zs_handle_cachep, h);
+	if (empty) {
+		atomic_long_sub(class->pages_per_zspage,
+				&pool->pages_allocated);
+		free_zspage(zspage);
+	}
+}
+EXPORT_SYMBOL_GPL(zs_free);
+
+/* Copy len bytes between buf and a range of a zspage */
+static void zspage_copy(struct zspage *zspage, unsigned int off, char *buf,
+			unsigned int len, bool to_zspage)
+{
+	while (len) {
+		unsigned int poff = off & ~PAGE_MASK;
+		unsigned int chunk = min_t(unsigned int, len, PAGE_SIZE - poff);
+		char *addr = kmap_atomic(zspage->pages[off >> PAGE_SHIFT]);
+
+		if (to_zspage)
+			memcpy(addr + poff, buf, chunk);
+		else
+			memcpy(buf, addr + poff, chunk);
+		kunmap_atomic(addr);
+
+		buf += chunk;
+		off += chunk;
+		len -= chunk;
+	}
+}
+
+/**
+ * zs_map_object - get a pointer to an object's data
+ * @pool: pool the object belongs to
+ * @handle: handle returned by zs_malloc()
+ * @mm: whether the data is read, written or both
+ *
+ * The object stays pinned and preemption disabled until
+ * zs_unmap_object(), so only one object may be mapped per cpu at a time
+ * and the caller must not sleep in between.  Atomic kmaps taken by the
+ * caller before the call must be released after zs_unmap_object().
+ */
+void *zs_map_object(struct zs_pool *pool, unsigned long handle,
+		    enum zs_mapmode mm)
+{
+	unsigned long *h = (unsigned long *)handle;
+	struct zs_map_area *area;
+	struct zspage *zspage;
+	unsigned int idx, off, size;
+
+	pin_handle(h);
+	zspage = location_to_zspage(handle_location(h), &idx);
+	off = idx * zspage->class->size + ZS_HANDLE_SIZE;
+	size = zspage->class->size - ZS_HANDLE_SIZE;
+
+	area = this_cpu_ptr(pool->map_area);
+	area->zspage = zspage;
+	area->off = off;
+	area->size = size;
+	area->mm = mm;
+
+	if ((off & ~PAGE_MASK) + size <= PAGE_SIZE) {
+		area->vaddr = kmap_atomic(zspage->pages[off >> PAGE_SHIFT]);
+		return (char *)area->vaddr + (off & ~PAGE_MASK);
+	}
+
+	/* Object straddles two pages */
+	area->vaddr = NULL;
+	if (mm != ZS_MM_WO)
+		zspage_copy(zspage, off, area->buf, size, false);
+	return area->buf;
+}
+EXPORT_SYMBOL_GPL(zs_map_object);
+
+void zs_unmap_object(struct zs_pool *pool, unsigned long handle)
+{
+	struct zs_map_area *area = this_cpu_ptr(pool->map_area);
+
+	if (area->vaddr)
+		kunmap_atomic(area->vaddr);
+	else if (area->mm != ZS_MM_RO)
+		zspage_copy(area->zspage, area->off, area->buf, area->size,
+			    true);
+
+	unpin_handle((unsigned long *)handle);
+}
+EXPORT_SYMBOL_GPL(zs_unmap_object);
+
+/* Copy an object's data (not its header) between two zspages */
+static void obj_copy(struct size_class *class, struct zspage *dst,
+		     unsigned int didx, struct zspage *src, unsigned int sidx)
+{
+	unsigned int soff = sidx * class->size + ZS_HANDLE_SIZE;
+	unsigned int doff = didx * class->size + ZS_HANDLE_SIZE;
+	unsigned int len = class->size - ZS_HANDLE_SIZE;
+
+	while (len) {
+		unsigned int spoff = soff & ~PAGE_MASK;
+		unsigned int dpoff = doff & ~PAGE_MASK;
+		unsigned int chunk;
+		char *saddr, *daddr;
+
+		chunk = min_t(unsigned int, len, PAGE_SIZE - spoff);
+		chunk = min_t(unsigned int, chunk, PAGE_SIZE - dpoff);
+
+		saddr = kmap_atomic(src->pages[soff >> PAGE_SHIFT]);
+		daddr = kmap_atomic(dst->pages[doff >> PAGE_SHIFT]);
+		memcpy(daddr + dpoff, saddr + spoff, chunk);
+		kunmap_atomic(daddr);
+		kunmap_atomic(saddr);
+
+		soff += chunk;
+		doff += chunk;
+		len -= chunk;
+	}
+}
+
+/* Fullest zspage other than src with room for another object */
+static struct zspage *find_dst_zspage(struct size_class *class,
+				      struct zspage *src)
+{
+	struct zspage *zspage;
+	int fg;
+
+	for (fg = ZS_ALMOST_FULL; fg <= ZS_ALMOST_EMPTY; fg++)
+		list_for_each_entry(zspage, &class->fullness_list[fg], list)
+			if (zspage != src)
+				return zspage;
+
+	return NULL;
+}
+
+/*
+ * Move every object of src that is not pinned into other zspages of
+ * the class.  Called with class->lock held; returns true if src ended
+ * up empty, in which case it is off the lists and must be freed.
+ */
+static bool migrate_zspage(struct size_class *class, struct zspage *src)
+{
+	unsigned int idx;
+
+	for (idx = 0; idx < class->objs_per_zspage; idx++) {
+		unsigned long head = obj_head_read(src, idx);
+		unsigned long *h;
+		struct zspage *dst;
+		unsigned int didx;
+
+		if (!(head & OBJ_ALLOCATED_TAG))
+			continue;
+
+		h = (unsigned long *)(head & ~OBJ_ALLOCATED_TAG);
+		/* Mapped or being freed: leave it where it is */
+		if (!trypin_handle(h))
+			continue;
+
+		dst = find_dst_zspage(class, src);
+		if (!dst) {
+			unpin_handle(h);
+			break;
+		}
+
+		didx = obj_alloc(class, dst, h);
+		obj_copy(class, dst, didx, src, idx);
+		*h = (obj_location(dst, didx) << 1) | (1UL << HANDLE_PIN_BIT);
+		if (obj_free(class, src, idx)) {
+			unpin_handle(h);
+			return true;
+		}
+		unpin_handle(h);
+	}
+
+	return false;
+}
+
+static unsigned long compact_class(struct zs_pool *pool,
+				   struct size_class *class)
+{
+	unsigned long freed = 0;
+	struct zspage *src;
+
+	spin_lock(&class->lock);
+	for (;;) {
+		unsigned long free_objs = class->nr_zspages *
+				class->objs_per_zspage - class->nr_objs;
+		struct list_head *head = &class->fullness_list[ZS_ALMOST_EMPTY];
+
+		/* Nothing to gain unless a whole zspage's worth is free */
+		if (free_objs < class->objs_per_zspage || list_empty(head))
+			break;
+
+		/* Zspages that just lost objects go to the front, drain the tail */
+		src = list_entry(head->prev, struct zspage, list);
+		if (!migrate_zspage(class, src))
+			break;
+
+		spin_unlock(&class->lock);
+		free_zspage(src);
+		freed += class->pages_per_zspage;
+		cond_resched();
+		spin_lock(&class->lock);
+	}
+	spin_unlock(&class->lock);
+
+	return freed;
+}
+
+/**
+ * zs_compact - defragment the pool
+ * @pool: pool to compact
+ *
+ * Moves objects out of sparsely used zspages into fuller ones of the
+ * same size class and releases the emptied zspages.  Objects that are
+ * mapped at the time stay in place.  May sleep; returns the number of
+ * pages freed.
+ */
+unsigned long zs_compact(struct zs_pool *pool)
+{
+	unsigned long freed = 0;
+	unsigned int i;
+
+	for (i = 0; i < ZS_NR_CLASSES; i++) {
+		freed += compact_class(pool, &pool->classes[i]);
+		cond_resched();
+	}
+
+	atomic_long_sub(freed, &pool->pages_allocated);
+	atomic_long_add(freed, &pool->pages_compacted);
+
+	return freed;
+}
+EXPORT_SYMBOL_GPL(zs_compact);
+
+u64 zs_get_total_size_bytes(struct zs_pool *pool)
+{
+	return (u64)atomic_long_read(&pool->pages_allocated) << PAGE_SHIFT;
+}
+EXPORT_SYMBOL_GPL(zs_get_total_size_bytes);
+
+/* Snapshot of the pool usage, classes are sampled without locking */
+void zs_pool_stats(struct zs_pool *pool, struct zs_pool_stats *stats)
+{
+	unsigned int i;
+
+	memset(stats, 0, sizeof(*stats));
+	for (i = 0; i < ZS_NR_CLASSES; i++) {
+		struct size_class *class = &pool->classes[i];
+		unsigned long nr_objs = ACCESS_ONCE(class->nr_objs);
+
+		stats->objs += nr_objs;
+		stats->obj_bytes += (u64)nr_objs * class->size;
+	}
+	stats->pages = atomic_long_read(&pool->pages_allocated);
+	stats->pages_compacted = atomic_long_read(&pool->pages_compacted);
+}
+EXPORT_SYMBOL_GPL(zs_pool_stats);
+
+static void zs_free_map_areas(struct zs_pool *pool)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		free_page((unsigned long)per_cpu_ptr(pool->map_area, cpu)->buf);
+	free_percpu(pool->map_area);
+}
+
+/**
+ * zs_create_pool - create an allocation pool
+ * @name: pool name, for debugging
+ * @flags: gfp flags used to allocate backing pages, may include
+ *	__GFP_HIGHMEM
+ */
+struct zs_pool *zs_create_pool(const char *name, gfp_t flags)
+{
+	struct zs_pool *pool;
+	unsigned int i;
+	int cpu;
+
+	BUILD_BUG_ON(ZS_MAX_OBJS_PER_ZSPAGE > OBJ_FREE_END);
+
+	pool = kzalloc(sizeof(*pool), GFP_KERNEL);
+	if (!pool)
+		return NULL;
+
+	if (zs_get_caches())
+		goto fail_caches;
+
+	pool->map_area = alloc_percpu(struct zs_map_area);
+	if (!pool->map_area)
+		goto fail_map;
+	for_each_possible_cpu(cpu) {
+		char *buf = (char *)__get_free_page(GFP_KERNEL);
+
+		if (!buf)
+			goto fail_buf;
+		per_cpu_ptr(pool->map_area, cpu)->buf = buf;
+	}
+
+	for (i = 0; i < ZS_NR_CLASSES; i++) {
+		struct size_class *class = &pool->classes[i];
+		int fg;
+
+		spin_lock_init(&class->lock);
+		class->size = ZS_MIN_ALLOC_SIZE + i * ZS_ALIGN;
+		class->pages_per_zspage = get_pages_per_zspage(class->size);
+		class->objs_per_zspage = class->pages_per_zspage * PAGE_SIZE /
+					 class->size;
+		for (fg = 0; fg < NR_FULLNESS_GROUPS; fg++)
+			INIT_LIST_HEAD(&class->fullness_list[fg]);
+	}
+
+	pool->name = name;
+	pool->flags = flags;
+
+	return pool;
+
+fail_buf:
+	zs_free_map_areas(pool);
+fail_map:
+	zs_put_caches();
+fail_caches:
+	kfree(pool);
+	return NULL;
+}
+EXPORT_SYMBOL_GPL(zs_create_pool);
+
+void zs_destroy_pool(struct zs_pool *pool)
+{
+	unsigned int i;
+
+	for (i = 0; i < ZS_NR_CLASSES; i++) {
+		struct size_class *class = &pool->classes[i];
+		int fg;
+
+		for (fg = 0; fg < NR_FULLNESS_GROUPS; fg++) {
+			if (!list_empty(&class->fullness_list[fg]))
+				pr_info("Freeing non-empty class %u of pool %s\n",
+					class->size, pool->name);
+		}
+	}
+
+	zs_free_map_areas(pool);
+	zs_put_caches();
+	kfree(pool);
+}
+EXPORT_SYMBOL_GPL(zs_destroy_pool);
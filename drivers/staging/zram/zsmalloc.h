@@ -0,0 +1,50 @@
+/*
+ * zsmalloc memory allocator
+ *
+ * This code is released using a dual license strategy: BSD/GPL
+ * You can choose the licence that better fits your requirements.
+ *
+ * Released under the terms of 3-clause BSD License
+ * Released under the terms of GNU General Public License Version 2.0
+ */
+
+#ifndef _ZS_MALLOC_H_
+#define _ZS_MALLOC_H_
+
+#include <linux/types.h>
+
+/* Every object carries a back-pointer to its handle */
+#define ZS_HANDLE_SIZE		(sizeof(unsigned long))
+#define ZS_MAX_ALLOC_SIZE	(PAGE_SIZE - ZS_HANDLE_SIZE)
+
+enum zs_mapmode {
+	ZS_MM_RW,	/* read and write back */
+	ZS_MM_RO,	/* read only, nothing is written back */
+	ZS_MM_WO,	/* write only, old contents are not read */
+};
+
+struct zs_pool_stats {
+	unsigned long pages;		/* pages backing the pool */
+	unsigned long objs;		/* objects allocated */
+	u64 obj_bytes;			/* bytes of the objects' size classes */
+	unsigned long pages_compacted;	/* pages freed by zs_compact() */
+};
+
+struct zs_pool;
+
+struct zs_pool *zs_create_pool(const char *name, gfp_t flags);
+void zs_destroy_pool(struct zs_pool *pool);
+
+unsigned long zs_malloc(struct zs_pool *pool, size_t size);
+void zs_free(struct zs_pool *pool, unsigned long handle);
+
+void *zs_map_object(struct zs_pool *pool, unsigned long handle,
+			enum zs_mapmode mm);
+void zs_unmap_object(struct zs_pool *pool, unsigned long handle);
+
+unsigned long zs_compact(struct zs_pool *pool);
+
+u64 zs_get_total_size_bytes(struct zs_pool *pool);
+void zs_pool_stats(struct zs_pool *pool, struct zs_pool_stats *stats);
+
+#endif
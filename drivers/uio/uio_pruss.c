@@ -2,7 +2,9 @@
  * Programmable Real-Time Unit Sub System (PRUSS) UIO driver (uio_pruss)
  *
  * This driver exports PRUSS host event out interrupts and PRUSS, L3 RAM,
- * and DDR RAM to user space for applications interacting with PRUSS firmware
+ * and DDR RAM to user space for applications interacting with PRUSS firmware.
+ * It also lets kernel drivers load PRU firmware, ring PRU doorbells, handle
+ * host events and pass messages through shared memory, see <linux/pruss.h>.
  *
  * Copyright (C) 2010-11 Texas Instruments Incorporated - http://www.ti.com/
  *
@@ -25,6 +27,10 @@
 #include <linux/clk.h>
 #include <linux/dma-mapping.h>
 #include <linux/slab.h>
+#include <linux/firmware.h>
+#include <linux/log2.h>
+#include <linux/pruss.h>
+#include <linux/mutex.h>
 
 #ifdef ARCH_DAVINCI_DA850
 #define ENABLE_SRAM_SUPPORT
@@ -61,11 +67,18 @@ MODULE_PARM_DESC(extram_pool_sz, "external ram pool size to allocate");
 */
 #define MAX_PRUSS_EVT	8
 
+#define PINTC_SISR	0x0020
+#define PINTC_SICR	0x0024
 #define PINTC_HIDISR	0x0038
 #define PINTC_HIPIR	0x0900
 #define HIPIR_NOPEND	0x80000000
 #define PINTC_HIER	0x1500
 
+#define PRU_CONTROL		0x0000
+#define PRU_CONTROL_SOFT_RST_N	BIT(0)
+#define PRU_CONTROL_ENABLE	BIT(1)
+#define MAX_PRU			2
+
 struct uio_pruss_dev {
 	struct uio_info *info;
 	struct clk *pruss_clk;
@@ -76,10 +89,28 @@ struct uio_pruss_dev {
 	void *ddr_vaddr;
 	unsigned int hostirq_start;
 	unsigned int pintc_base;
+	struct device *dev;
+	u32 pru_ctrl_base[MAX_PRU];
+	u32 pru_iram_base[MAX_PRU];
+	u32 pru_iram_size;
+	/* host events taken over by kernel drivers */
+	pruss_event_handler_t evt_handler[MAX_PRUSS_EVT];
+	void *evt_data[MAX_PRUSS_EVT];
+	int nr_irqs;	/* host event IRQs requested so far */
 };
 
-static irqreturn_t pruss_handler(int irq, struct uio_info *info)
+/* there is a single PRUSS instance on the supported SoCs */
+static struct uio_pruss_dev *pruss_dev;
+/* guards pruss_dev and the evt_handler[] slots */
+static DEFINE_MUTEX(pruss_evt_mutex);
+
+/*
+ * The host event IRQs are requested here rather than by the UIO core, so
+ * that events owned by a kernel driver never wake up user space.
+ */
+static irqreturn_t pruss_handler(int irq, void *dev_id)
 {
+	struct uio_info *info = dev_id;
 	struct uio_pruss_dev *gdev = info->priv;
 	int intr_bit = (irq - gdev->hostirq_start + 2);
 	int val, intr_mask = (1 << intr_bit);
@@ -87,6 +118,17 @@ static irqreturn_t pruss_handler(int irq, struct uio_info *info)
 	void __iomem *intren_reg = base + PINTC_HIER;
 	void __iomem *intrdis_reg = base + PINTC_HIDISR;
 	void __iomem *intrstat_reg = base + PINTC_HIPIR + (intr_bit << 2);
+	int evt = irq - gdev->hostirq_start;
+	pruss_event_handler_t handler = ACCESS_ONCE(gdev->evt_handler[evt]);
+
+	/*
+	 * Events owned by a kernel driver stay enabled; the handler clears
+	 * the system event(s) mapped to this host event.
+	 */
+	if (handler) {
+		handler(evt, gdev->evt_data[evt]);
+		return IRQ_HANDLED;
+	}
 
 	val = ioread32(intren_reg);
 	/* Is interrupt enabled and active ? */
@@ -94,15 +136,340 @@ static irqreturn_t pruss_handler(int irq, struct uio_info *info)
 		return IRQ_NONE;
 	/* Disable interrupt */
 	iowrite32(intr_bit, intrdis_reg);
+	uio_event_notify(info);
 	return IRQ_HANDLED;
 }
 
+/**
+ * pruss_get() - get the PRUSS instance for in-kernel use
+ *
+ * Returns ERR_PTR(-ENODEV) if the PRUSS has not been probed (yet).  The
+ * instance, and this module, stay around until pruss_put() is called.
+ */
+struct uio_pruss_dev *pruss_get(void)
+{
+	struct uio_pruss_dev *gdev = ERR_PTR(-ENODEV);
+
+	mutex_lock(&pruss_evt_mutex);
+	if (pruss_dev && try_module_get(THIS_MODULE)) {
+		gdev = pruss_dev;
+		get_device(gdev->dev);
+	}
+	mutex_unlock(&pruss_evt_mutex);
+	return gdev;
+}
+EXPORT_SYMBOL_GPL(pruss_get);
+
+/**
+ * pruss_put() - release a PRUSS instance from pruss_get()
+ * @gdev: PRUSS instance
+ */
+void pruss_put(struct uio_pruss_dev *gdev)
+{
+	put_device(gdev->dev);
+	module_put(THIS_MODULE);
+}
+EXPORT_SYMBOL_GPL(pruss_put);
+
+/**
+ * pruss_boot() - load firmware into a PRU and start it
+ * @gdev: PRUSS instance
+ * @pru: PRU core, 0 or 1
+ * @fw_name: firmware image, raw instructions loaded at address 0
+ *
+ * The PRU is halted and reset before loading and starts executing at
+ * address 0.  This must not be mixed with loading from user space.
+ */
+int pruss_boot(struct uio_pruss_dev *gdev, int pru, const char *fw_name)
+{
+	const struct firmware *fw;
+	void __iomem *ctrl;
+	int ret;
+
+	if (pru < 0 || pru >= MAX_PRU || !gdev->pru_iram_size)
+		return -EINVAL;
+
+	ret = request_firmware(&fw, fw_name, gdev->dev);
+	if (ret)
+		return ret;
+
+	if (fw->size > gdev->pru_iram_size || fw->size % 4) {
+		dev_err(gdev->dev, "%s: bad PRU firmware size %zu\n",
+			fw_name, fw->size);
+		ret = -EINVAL;
+		goto out;
+	}
+
+	ctrl = gdev->prussio_vaddr + gdev->pru_ctrl_base[pru];
+	iowrite32(0, ctrl + PRU_CONTROL);
+	memcpy_toio(gdev->prussio_vaddr + gdev->pru_iram_base[pru],
+		    fw->data, fw->size);
+	iowrite32(PRU_CONTROL_ENABLE | PRU_CONTROL_SOFT_RST_N,
+		  ctrl + PRU_CONTROL);
+out:
+	release_firmware(fw);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(pruss_boot);
+
+/**
+ * pruss_halt() - stop a PRU core
+ * @gdev: PRUSS instance
+ * @pru: PRU core, 0 or 1
+ */
+void pruss_halt(struct uio_pruss_dev *gdev, int pru)
+{
+	void __iomem *ctrl;
+	u32 val;
+
+	if (pru < 0 || pru >= MAX_PRU || !gdev->pru_iram_size)
+		return;
+
+	ctrl = gdev->prussio_vaddr + gdev->pru_ctrl_base[pru];
+	val = ioread32(ctrl + PRU_CONTROL);
+	iowrite32(val & ~PRU_CONTROL_ENABLE, ctrl + PRU_CONTROL);
+}
+EXPORT_SYMBOL_GPL(pruss_halt);
+
+/**
+ * pruss_send_event() - raise a PRUSS system event (doorbell to the PRUs)
+ * @gdev: PRUSS instance
+ * @sysevent: system event number, as mapped by the PRU INTC setup
+ */
+void pruss_send_event(struct uio_pruss_dev *gdev, unsigned int sysevent)
+{
+	/* make ring updates visible to the PRU before it is woken up */
+	wmb();
+	iowrite32(sysevent, gdev->prussio_vaddr + gdev->pintc_base +
+		  PINTC_SISR);
+}
+EXPORT_SYMBOL_GPL(pruss_send_event);
+
+/**
+ * pruss_clear_event() - acknowledge a PRUSS system event
+ * @gdev: PRUSS instance
+ * @sysevent: system event number
+ */
+void pruss_clear_event(struct uio_pruss_dev *gdev, unsigned int sysevent)
+{
+	iowrite32(sysevent, gdev->prussio_vaddr + gdev->pintc_base +
+		  PINTC_SICR);
+}
+EXPORT_SYMBOL_GPL(pruss_clear_event);
+
+/**
+ * pruss_request_event() - handle a host event out interrupt in the kernel
+ * @gdev: PRUSS instance
+ * @evtout: host event, 0 to MAX_PRUSS_EVT - 1
+ * @handler: called in hard interrupt context, must clear the system event
+ * @data: passed to @handler
+ *
+ * The event is not forwarded to user space while it is owned by a kernel
+ * driver.
+ */
+int pruss_request_event(struct uio_pruss_dev *gdev, int evtout,
+			pruss_event_handler_t handler, void *data)
+{
+	int ret = 0;
+
+	if (evtout < 0 || evtout >= MAX_PRUSS_EVT || !handler)
+		return -EINVAL;
+
+	mutex_lock(&pruss_evt_mutex);
+	if (gdev->evt_handler[evtout]) {
+		ret = -EBUSY;
+	} else {
+		gdev->evt_data[evtout] = data;
+		/* the handler must not see stale data */
+		smp_wmb();
+		ACCESS_ONCE(gdev->evt_handler[evtout]) = handler;
+	}
+	mutex_unlock(&pruss_evt_mutex);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(pruss_request_event);
+
+/**
+ * pruss_free_event() - give a host event back to user space
+ * @gdev: PRUSS instance
+ * @evtout: host event passed to pruss_request_event()
+ */
+void pruss_free_event(struct uio_pruss_dev *gdev, int evtout)
+{
+	if (evtout < 0 || evtout >= MAX_PRUSS_EVT)
+		return;
+
+	mutex_lock(&pruss_evt_mutex);
+	ACCESS_ONCE(gdev->evt_handler[evtout]) = NULL;
+	synchronize_irq(gdev->hostirq_start + evtout);
+	gdev->evt_data[evtout] = NULL;
+	mutex_unlock(&pruss_evt_mutex);
+}
+EXPORT_SYMBOL_GPL(pruss_free_event);
+
+static void pruss_ring_copy_in(struct pruss_ring *ring, u32 pos,
+			       const void *src, size_t len)
+{
+	u32 off = pos & (ring->size - 1);
+	size_t n = min_t(size_t, len, ring->size - off);
+
+	memcpy(ring->hdr->data + off, src, n);
+	memcpy(ring->hdr->data, src + n, len - n);
+}
+
+static void pruss_ring_copy_out(struct pruss_ring *ring, u32 pos,
+				void *dst, size_t len)
+{
+	u32 off = pos & (ring->size - 1);
+	size_t n = min_t(size_t, len, ring->size - off);
+
+	memcpy(dst, ring->hdr->data + off, n);
+	memcpy(dst + n, ring->hdr->data, len - n);
+}
+
+/**
+ * pruss_ring_init() - set up an empty message ring
+ * @ring: ring handle to initialize
+ * @mem: shared memory, at least 32 bytes, 4 byte aligned
+ * @len: size of @mem; the data area is rounded down to a power of 2
+ */
+int pruss_ring_init(struct pruss_ring *ring, void *mem, size_t len)
+{
+	struct pruss_ring_hdr *hdr = mem;
+
+	if (len < sizeof(*hdr) + 16 || (unsigned long)mem % 4)
+		return -EINVAL;
+
+	hdr->head = 0;
+	hdr->tail = 0;
+	hdr->size = rounddown_pow_of_two(len - sizeof(*hdr));
+	wmb();
+
+	ring->hdr = hdr;
+	ring->size = hdr->size;
+	return 0;
+}
+EXPORT_SYMBOL_GPL(pruss_ring_init);
+
+/**
+ * pruss_ring_attach() - use a ring set up by the PRU firmware
+ * @ring: ring handle to initialize
+ * @mem: shared memory holding the ring
+ * @len: size of @mem
+ *
+ * Returns -EINVAL if the firmware's ring size is not a power of 2 or does
+ * not fit into @len.
+ */
+int pruss_ring_attach(struct pruss_ring *ring, void *mem, size_t len)
+{
+	struct pruss_ring_hdr *hdr = mem;
+	u32 size;
+
+	if (len < sizeof(*hdr) + 16 || (unsigned long)mem % 4)
+		return -EINVAL;
+
+	size = ACCESS_ONCE(hdr->size);
+	if (size < 16 || !is_power_of_2(size) || size > len - sizeof(*hdr))
+		return -EINVAL;
+
+	ring->hdr = hdr;
+	ring->size = size;
+	return 0;
+}
+EXPORT_SYMBOL_GPL(pruss_ring_attach);
+
+/**
+ * pruss_ring_write() - append one message to a ring
+ * @ring: ring the caller is the only producer of
+ * @buf: message
+ * @len: message length
+ *
+ * Returns 0, -ENOSPC if the consumer has not made enough room yet, or
+ * -EIO if the ring indices are corrupt.  Follow up with pruss_send_event() if the PRU waits for a doorbell.
+ */
+int pruss_ring_write(struct pruss_ring *ring, const void *buf, size_t len)
+{
+	struct pruss_ring_hdr *hdr = ring->hdr;
+	u32 head = hdr->head;
+	u32 tail = ACCESS_ONCE(hdr->tail);
+	u32 need = sizeof(u32) + ALIGN(len, 4);
+	u32 msg_len = len;
+
+	if (head - tail > ring->size)
+		return -EIO;
+	if (len > ring->size || need > ring->size - (head - tail))
+		return -ENOSPC;
+
+	/* the consumer must be done with the space before it is reused */
+	mb();
+	pruss_ring_copy_in(ring, head, &msg_len, sizeof(msg_len));
+	pruss_ring_copy_in(ring, head + sizeof(msg_len), buf, len);
+
+	/* publish the message only once it is complete */
+	wmb();
+	ACCESS_ONCE(hdr->head) = head + need;
+	return 0;
+}
+EXPORT_SYMBOL_GPL(pruss_ring_write);
+
+/**
+ * pruss_ring_read() - take one message off a ring
+ * @ring: ring the caller is the only consumer of
+ * @buf: buffer for the message
+ * @len: size of @buf
+ *
+ * Returns the message length, -EAGAIN if the ring is empty, -EMSGSIZE if
+ * the message does not fit into @buf (it is left in the ring), or -EIO if
+ * the ring indices or the message length are corrupt.
+ */
+int pruss_ring_read(struct pruss_ring *ring, void *buf, size_t len)
+{
+	struct pruss_ring_hdr *hdr = ring->hdr;
+	u32 tail = hdr->tail;
+	u32 head = ACCESS_ONCE(hdr->head);
+	u32 msg_len;
+
+	if (head == tail)
+		return -EAGAIN;
+	/* never trust the other side's index to stay within the ring */
+	if (head - tail > ring->size || head - tail < sizeof(msg_len))
+		return -EIO;
+
+	/* read the message only after seeing the producer's head update */
+	rmb();
+	pruss_ring_copy_out(ring, tail, &msg_len, sizeof(msg_len));
+	if (msg_len > ring->size - sizeof(msg_len) ||
+	    msg_len > head - tail - sizeof(msg_len))
+		return -EIO;
+	if (msg_len > len)
+		return -EMSGSIZE;
+	pruss_ring_copy_out(ring, tail + sizeof(msg_len), buf, msg_len);
+
+	/* the producer may reuse the space once tail has moved */
+	mb();
+	ACCESS_ONCE(hdr->tail) = tail + sizeof(msg_len) + ALIGN(msg_len, 4);
+	return msg_len;
+}
+EXPORT_SYMBOL_GPL(pruss_ring_read);
+
+/**
+ * pruss_ring_empty() - check a ring for pending messages
+ * @ring: ring handle
+ */
+bool pruss_ring_empty(struct pruss_ring *ring)
+{
+	return ACCESS_ONCE(ring->hdr->head) == ACCESS_ONCE(ring->hdr->tail);
+}
+EXPORT_SYMBOL_GPL(pruss_ring_empty);
+
 static void pruss_cleanup(struct platform_device *dev,
 			struct uio_pruss_dev *gdev)
 {
 	int cnt;
 	struct uio_info *p = gdev->info;
 
+	for (cnt = 0; cnt < gdev->nr_irqs; cnt++)
+		free_irq(gdev->hostirq_start + cnt, &gdev->info[cnt]);
 	for (cnt = 0; cnt < MAX_PRUSS_EVT; cnt++, p++) {
 		uio_unregister_device(p);
 		kfree(p->name);
@@ -189,6 +556,12 @@ static int __devinit pruss_probe(struct platform_device *dev)
 
 	gdev->pintc_base = pdata->pintc_base;
 	gdev->hostirq_start = platform_get_irq(dev, 0);
+	gdev->dev = &dev->dev;
+	for (cnt = 0; cnt < MAX_PRU; cnt++) {
+		gdev->pru_ctrl_base[cnt] = pdata->pru_ctrl_base[cnt];
+		gdev->pru_iram_base[cnt] = pdata->pru_iram_base[cnt];
+	}
+	gdev->pru_iram_size = pdata->pru_iram_size;
 
 	for (cnt = 0, p = gdev->info; cnt < MAX_PRUSS_EVT; cnt++, p++) {
 		p->mem[0].addr = regs_prussio->start;
@@ -204,17 +577,25 @@ static int __devinit pruss_probe(struct platform_device *dev)
 		p->name = kasprintf(GFP_KERNEL, "pruss_evt%d", cnt);
 		p->version = DRV_VERSION;
 
-		/* Register PRUSS IRQ lines */
-		p->irq = gdev->hostirq_start + cnt;
-		p->handler = pruss_handler;
+		/* PRUSS IRQ lines are requested below, see pruss_handler() */
+		p->irq = UIO_IRQ_CUSTOM;
 		p->priv = gdev;
 
 		ret = uio_register_device(&dev->dev, p);
 		if (ret < 0)
 			goto out_free;
+
+		ret = request_irq(gdev->hostirq_start + cnt, pruss_handler, 0,
+				  p->name, p);
+		if (ret < 0)
+			goto out_free;
+		gdev->nr_irqs++;
 	}
 
 	platform_set_drvdata(dev, gdev);
+	mutex_lock(&pruss_evt_mutex);
+	pruss_dev = gdev;
+	mutex_unlock(&pruss_evt_mutex);
 	return 0;
 
 out_free:
@@ -226,6 +607,9 @@ static int __devexit pruss_remove(struct platform_device *dev)
 {
 	struct uio_pruss_dev *gdev = platform_get_drvdata(dev);
 
+	mutex_lock(&pruss_evt_mutex);
+	pruss_dev = NULL;
+	mutex_unlock(&pruss_evt_mutex);
 	pruss_cleanup(dev, gdev);
 	platform_set_drvdata(dev, NULL);
 	return 0;
@@ -237,6 +621,8 @@ static struct platform_driver pruss_driver = {
 	.driver = {
 		   .name = DRV_NAME,
 		   .owner = THIS_MODULE,
+		   /* pruss_get() users hold a module, not a driver reference */
+		   .suppress_bind_attrs = true,
 		   },
 };
 
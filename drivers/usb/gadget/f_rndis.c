@@ -83,6 +83,20 @@ static inline struct f_rndis *func_to_rndis(struct usb_function *f)
 	return container_of(f, struct f_rndis, port.func);
 }
 
+/*
+ * RNDIS lets several packets share one USB transfer.  That saves per
+ * transfer overhead (completion IRQs, DMA setup) on the device side.
+ */
+static unsigned int rndis_ul_max_pkt_per_xfer = 3;
+module_param(rndis_ul_max_pkt_per_xfer, uint, S_IRUGO);
+MODULE_PARM_DESC(rndis_ul_max_pkt_per_xfer,
+		"Maximum packets per host-to-device transfer");
+
+static unsigned int rndis_dl_max_pkt_per_xfer = 8;
+module_param(rndis_dl_max_pkt_per_xfer, uint, S_IRUGO);
+MODULE_PARM_DESC(rndis_dl_max_pkt_per_xfer,
+		"Maximum packets per device-to-host transfer");
+
 /* peak (theoretical) bulk transfer rate in bits-per-second */
 static unsigned int bitrate(struct usb_gadget *g)
 {
@@ -454,6 +468,9 @@ static void rndis_command_complete(struct usb_ep *ep, struct usb_request *req)
 	if (status < 0)
 		ERROR(cdev, "RNDIS command error %d, %d/%d\n",
 			status, req->actual, req->length);
+	/* eth_start_xmit() reads this once and validates it */
+	ACCESS_ONCE(rndis->port.dl_max_xfer_size) =
+			rndis_get_dl_max_xfer_size(rndis->config);
 //	spin_unlock(&dev->lock);
 }
 
@@ -595,6 +612,8 @@ static int rndis_set_alt(struct usb_function *f, unsigned intf, unsigned alt)
 
 		rndis_set_param_dev(rndis->config, net,
 				&rndis->port.cdc_filter);
+		rndis_set_max_pkt_xfer(rndis->config,
+				rndis->port.ul_max_pkts_per_xfer);
 	} else
 		goto fail;
 
@@ -903,6 +922,9 @@ rndis_bind_config(struct usb_configuration *c, u8 ethaddr[ETH_ALEN])
 	rndis->port.header_len = sizeof(struct rndis_packet_msg_type);
 	rndis->port.wrap = rndis_add_header;
 	rndis->port.unwrap = rndis_rm_hdr;
+	rndis->port.ul_max_pkts_per_xfer = clamp(rndis_ul_max_pkt_per_xfer,
+						 1U, 255U);
+	rndis->port.dl_max_pkts_per_xfer = rndis_dl_max_pkt_per_xfer;
 
 	rndis->port.func.name = "rndis";
 	rndis->port.func.strings = rndis_strings;
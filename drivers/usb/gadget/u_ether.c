@@ -56,10 +56,14 @@ struct eth_dev {
 	struct net_device	*net;
 	struct usb_gadget	*gadget;
 
-	spinlock_t		req_lock;	/* guard {rx,tx}_reqs */
+	spinlock_t		req_lock;	/* guard {rx,tx}_reqs, tx_aggr_* */
 	struct list_head	tx_reqs, rx_reqs;
 	atomic_t		tx_qlen;
 
+	/* frames waiting to be sent in one multi-frame transfer */
+	struct sk_buff		*tx_aggr_skb;
+	unsigned		tx_aggr_pkts;
+
 	struct sk_buff_head	rx_frames;
 
 	unsigned		header_len;
@@ -83,6 +87,14 @@ struct eth_dev {
 
 #define DEFAULT_QLEN	2	/* double buffering by default */
 
+/* with multi-frame transfers, frames are held back (and aggregated)
+ * only while this many transfers are already queued
+ */
+#define TX_AGGR_QLEN	2
+
+/* multi-frame transfers keep their frame count in skb->cb */
+#define TX_AGGR_PKTS(skb)	(*(unsigned *)(skb)->cb)
+
 
 #ifdef CONFIG_USB_GADGET_DUALSPEED
 
@@ -229,6 +241,8 @@ rx_submit(struct eth_dev *dev, struct usb_request *req, gfp_t gfp_flags)
 	 */
 	size += sizeof(struct ethhdr) + dev->net->mtu + RX_EXTRA;
 	size += dev->port_usb->header_len;
+	if (dev->port_usb->ul_max_pkts_per_xfer > 1)
+		size *= dev->port_usb->ul_max_pkts_per_xfer;
 	size += out->maxpacket - 1;
 	size -= size % out->maxpacket;
 
@@ -481,6 +495,171 @@ static void tx_complete(struct usb_ep *ep, struct usb_request *req)
 		netif_wake_queue(dev->net);
 }
 
+static void tx_aggr_complete(struct usb_ep *ep, struct usb_request *req);
+
+/* queue the pending multi-frame transfer, if any; caller holds req_lock */
+static int tx_aggr_flush(struct eth_dev *dev, struct usb_ep *in)
+{
+	struct sk_buff		*skb = dev->tx_aggr_skb;
+	struct usb_request	*req;
+	int			retval;
+
+	if (!skb)
+		return 0;
+	if (list_empty(&dev->tx_reqs))
+		return -EBUSY;
+
+	req = container_of(dev->tx_reqs.next, struct usb_request, list);
+	list_del(&req->list);
+	dev->tx_aggr_skb = NULL;
+	TX_AGGR_PKTS(skb) = dev->tx_aggr_pkts;
+
+	req->buf = skb->data;
+	req->context = skb;
+	req->complete = tx_aggr_complete;
+	req->zero = 1;
+	req->length = skb->len;
+	/* see eth_start_xmit(); the buffer has one spare byte for this */
+	if (!dev->zlp && (req->length % in->maxpacket) == 0)
+		req->length++;
+	req->no_interrupt = 0;
+
+	retval = usb_ep_queue(in, req, GFP_ATOMIC);
+	if (retval) {
+		DBG(dev, "tx queue err %d\n", retval);
+		dev->net->stats.tx_dropped += TX_AGGR_PKTS(skb);
+		dev_kfree_skb_any(skb);
+		list_add(&req->list, &dev->tx_reqs);
+	} else {
+		dev->net->trans_start = jiffies;
+		atomic_inc(&dev->tx_qlen);
+	}
+	return retval;
+}
+
+static void tx_aggr_complete(struct usb_ep *ep, struct usb_request *req)
+{
+	struct sk_buff	*skb = req->context;
+	struct eth_dev	*dev = ep->driver_data;
+
+	switch (req->status) {
+	default:
+		dev->net->stats.tx_errors += TX_AGGR_PKTS(skb);
+		VDBG(dev, "tx err %d\n", req->status);
+		/* FALLTHROUGH */
+	case -ECONNRESET:		/* unlink */
+	case -ESHUTDOWN:		/* disconnect etc */
+		break;
+	case 0:
+		dev->net->stats.tx_bytes += skb->len;
+	}
+	dev->net->stats.tx_packets += TX_AGGR_PKTS(skb);
+
+	spin_lock(&dev->req_lock);
+	list_add(&req->list, &dev->tx_reqs);
+	/* frames queued up meanwhile go out right away */
+	tx_aggr_flush(dev, ep);
+	spin_unlock(&dev->req_lock);
+	dev_kfree_skb_any(skb);
+
+	atomic_dec(&dev->tx_qlen);
+	if (netif_carrier_ok(dev->net))
+		netif_wake_queue(dev->net);
+}
+
+/* does a frame of @len bytes still fit?  one byte is kept for zlp padding */
+static inline bool tx_aggr_fits(struct sk_buff *aggr, unsigned len,
+		unsigned max_size)
+{
+	return aggr->len + len <= max_size && len < skb_tailroom(aggr);
+}
+
+/*
+ * Transmit path for framings (RNDIS) which allow several frames per USB
+ * transfer.  While fewer than TX_AGGR_QLEN transfers are queued, each frame
+ * is sent right away, straight from its own skb.  Beyond that, frames are
+ * copied into one buffer until a request completes, the host's transfer
+ * size limit is reached or the frame count limit is hit.  Under load this
+ * cuts the number of transfers, and of DMA completion IRQs, by up to
+ * @max_pkts.
+ */
+static netdev_tx_t eth_start_xmit_aggr(struct eth_dev *dev,
+		struct sk_buff *skb, struct usb_ep *in,
+		unsigned max_pkts, unsigned max_size)
+{
+	struct net_device	*net = dev->net;
+	struct sk_buff		*aggr;
+	unsigned long		flags;
+	unsigned		length = skb->len + dev->header_len;
+	unsigned		size;
+
+	spin_lock_irqsave(&dev->req_lock, flags);
+	aggr = dev->tx_aggr_skb;
+	if (aggr && (!tx_aggr_fits(aggr, length, max_size) ||
+		     dev->tx_aggr_pkts >= max_pkts)) {
+		if (list_empty(&dev->tx_reqs)) {
+			/* tx_aggr_complete() wakes the queue again */
+			netif_stop_queue(net);
+			spin_unlock_irqrestore(&dev->req_lock, flags);
+			return NETDEV_TX_BUSY;
+		}
+		tx_aggr_flush(dev, in);
+	}
+	spin_unlock_irqrestore(&dev->req_lock, flags);
+
+	if (dev->wrap) {
+		spin_lock_irqsave(&dev->lock, flags);
+		if (dev->port_usb)
+			skb = dev->wrap(dev->port_usb, skb);
+		spin_unlock_irqrestore(&dev->lock, flags);
+		if (!skb)
+			goto drop;
+	}
+
+	spin_lock_irqsave(&dev->req_lock, flags);
+	aggr = dev->tx_aggr_skb;
+	if (aggr && !tx_aggr_fits(aggr, skb->len, max_size) && tx_aggr_flush(dev, in))
+		goto drop_unlock;
+
+	aggr = dev->tx_aggr_skb;
+	if (!aggr && atomic_read(&dev->tx_qlen) < TX_AGGR_QLEN &&
+	    !list_empty(&dev->tx_reqs)) {
+		/* link is idle enough: no copy, the frame goes out alone */
+		dev->tx_aggr_skb = skb;
+		dev->tx_aggr_pkts = 1;
+		tx_aggr_flush(dev, in);
+		spin_unlock_irqrestore(&dev->req_lock, flags);
+		return NETDEV_TX_OK;
+	}
+	if (!aggr) {
+		/* no point in a buffer larger than @max_pkts full frames */
+		size = min_t(unsigned, max_size, max_pkts *
+			     (net->mtu + ETH_HLEN + dev->header_len));
+		aggr = alloc_skb(max(size, skb->len) + 1, GFP_ATOMIC);
+		if (!aggr)
+			goto drop_unlock;
+		dev->tx_aggr_skb = aggr;
+		dev->tx_aggr_pkts = 0;
+	}
+	memcpy(skb_put(aggr, skb->len), skb->data, skb->len);
+	dev->tx_aggr_pkts++;
+
+	if (atomic_read(&dev->tx_qlen) < TX_AGGR_QLEN ||
+	    dev->tx_aggr_pkts >= max_pkts)
+		tx_aggr_flush(dev, in);
+	spin_unlock_irqrestore(&dev->req_lock, flags);
+
+	dev_kfree_skb_any(skb);
+	return NETDEV_TX_OK;
+
+drop_unlock:
+	spin_unlock_irqrestore(&dev->req_lock, flags);
+	dev_kfree_skb_any(skb);
+drop:
+	net->stats.tx_dropped++;
+	return NETDEV_TX_OK;
+}
+
 static inline int is_promisc(u16 cdc_filter)
 {
 	return cdc_filter & USB_CDC_PACKET_TYPE_PROMISCUOUS;
@@ -496,11 +675,15 @@ static netdev_tx_t eth_start_xmit(struct sk_buff *skb,
 	unsigned long		flags;
 	struct usb_ep		*in;
 	u16			cdc_filter;
+	u32			max_pkts = 0, max_size = 0;
 
 	spin_lock_irqsave(&dev->lock, flags);
 	if (dev->port_usb) {
 		in = dev->port_usb->in_ep;
 		cdc_filter = dev->port_usb->cdc_filter;
+		max_pkts = dev->port_usb->dl_max_pkts_per_xfer;
+		/* updated by the RNDIS control path without this lock */
+		max_size = ACCESS_ONCE(dev->port_usb->dl_max_xfer_size);
 	} else {
 		in = NULL;
 		cdc_filter = 0;
@@ -534,6 +717,11 @@ static netdev_tx_t eth_start_xmit(struct sk_buff *skb,
 		/* ignores USB_CDC_PACKET_TYPE_DIRECTED */
 	}
 
+	/* aggregate only if the host takes at least two full frames */
+	if (max_pkts > 1 &&
+	    max_size >= 2 * (net->mtu + ETH_HLEN + dev->header_len))
+		return eth_start_xmit_aggr(dev, skb, in, max_pkts, max_size);
+
 	spin_lock_irqsave(&dev->req_lock, flags);
 	/*
 	 * this freelist can be empty if an interrupt triggered disconnect()
@@ -966,6 +1154,10 @@ void gether_disconnect(struct gether *link)
 		usb_ep_free_request(link->in_ep, req);
 		spin_lock(&dev->req_lock);
 	}
+	if (dev->tx_aggr_skb) {
+		dev_kfree_skb_any(dev->tx_aggr_skb);
+		dev->tx_aggr_skb = NULL;
+	}
 	spin_unlock(&dev->req_lock);
 	link->in_ep->driver_data = NULL;
 	link->in_ep->desc = NULL;
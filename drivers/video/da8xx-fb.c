@@ -35,6 +35,7 @@
 #include <linux/delay.h>
 #include <linux/pm_runtime.h>
 #include <linux/lcm.h>
+#include <linux/eventfd.h>
 #include <video/da8xx-fb.h>
 #include <asm/mach-types.h>
 #include <asm/div64.h>
@@ -126,7 +127,7 @@
 #define  LCD_CLK_RESET_REG			0x70
 #define  LCD_CLK_MAIN_RESET			BIT(3)
 
-#define LCD_NUM_BUFFERS	2
+#define LCD_NUM_BUFFERS	CONFIG_FB_DA8XX_NUM_BUFFERS
 
 #define WSI_TIMEOUT	50
 #define PALETTE_SIZE	256
@@ -176,7 +177,20 @@ struct da8xx_fb_par {
 	 * LCDC has 2 ping pong DMA channels, channel 0
 	 * and channel 1.
 	 */
-	unsigned int		which_dma_channel_done;
+	int			which_dma_channel_done;
+
+	/*
+	 * Page flips, guarded by lock_for_chan_update.  A flip is armed by
+	 * writing it to the idle channel and reaches the screen when the
+	 * other channel completes its frame.  One more flip may be queued
+	 * behind it; a later pan replaces the queued one.
+	 */
+	int			flip_chan;	/* armed flip's channel or -1 */
+	bool			flip_queued;
+	unsigned int		flip_start;
+	unsigned int		flip_end;
+	wait_queue_head_t	flip_wait;
+	struct eventfd_ctx	*flip_eventfd;
 #ifdef CONFIG_CPU_FREQ
 	struct notifier_block	freq_transition;
 	unsigned int		lcd_fck_rate;
@@ -842,6 +856,50 @@ int unregister_vsync_cb(vsync_callback_t handler, void *arg, int idx)
 }
 EXPORT_SYMBOL(unregister_vsync_cb);
 
+static void lcd_write_dma_addr(struct da8xx_fb_par *par, int chan)
+{
+	if (chan == 0) {
+		lcdc_write(par->dma_start, LCD_DMA_FRM_BUF_BASE_ADDR_0_REG);
+		lcdc_write(par->dma_end, LCD_DMA_FRM_BUF_CEILING_ADDR_0_REG);
+	} else if (chan == 1) {
+		lcdc_write(par->dma_start, LCD_DMA_FRM_BUF_BASE_ADDR_1_REG);
+		lcdc_write(par->dma_end, LCD_DMA_FRM_BUF_CEILING_ADDR_1_REG);
+	}
+}
+
+/* Called from the ISR when DMA channel @chan has completed a frame */
+static void lcd_frame_done(struct da8xx_fb_par *par, int chan)
+{
+	bool flipped = false;
+
+	spin_lock(&par->lock_for_chan_update);
+	par->which_dma_channel_done = chan;
+
+	/* the other channel has just started scanning out the armed flip */
+	if (par->flip_chan >= 0 && par->flip_chan != chan) {
+		par->flip_chan = -1;
+		flipped = true;
+	}
+	/* arm the queued flip on the channel which has gone idle */
+	if (par->flip_chan < 0 && par->flip_queued) {
+		par->dma_start = par->flip_start;
+		par->dma_end = par->flip_end;
+		par->flip_queued = false;
+		par->flip_chan = chan;
+	}
+
+	lcd_write_dma_addr(par, chan);
+
+	if (flipped && par->flip_eventfd)
+		eventfd_signal(par->flip_eventfd, 1);
+	spin_unlock(&par->lock_for_chan_update);
+
+	par->vsync_flag = 1;
+	wake_up_interruptible(&par->vsync_wait);
+	if (flipped)
+		wake_up_interruptible(&par->flip_wait);
+}
+
 /* IRQ handler for version 2 of LCDC */
 static irqreturn_t lcdc_irq_handler_rev02(int irq, void *arg)
 {
@@ -876,25 +934,13 @@ static irqreturn_t lcdc_irq_handler_rev02(int irq, void *arg)
 		lcdc_write(stat, LCD_MASKED_STAT_REG);
 
 		if (stat & LCD_END_OF_FRAME0) {
-			par->which_dma_channel_done = 0;
-			lcdc_write(par->dma_start,
-				   LCD_DMA_FRM_BUF_BASE_ADDR_0_REG);
-			lcdc_write(par->dma_end,
-				   LCD_DMA_FRM_BUF_CEILING_ADDR_0_REG);
-			par->vsync_flag = 1;
-			wake_up_interruptible(&par->vsync_wait);
+			lcd_frame_done(par, 0);
 			if (vsync_cb_handler)
 				vsync_cb_handler(vsync_cb_arg);
 		}
 
 		if (stat & LCD_END_OF_FRAME1) {
-			par->which_dma_channel_done = 1;
-			lcdc_write(par->dma_start,
-				   LCD_DMA_FRM_BUF_BASE_ADDR_1_REG);
-			lcdc_write(par->dma_end,
-				   LCD_DMA_FRM_BUF_CEILING_ADDR_1_REG);
-			par->vsync_flag = 1;
-			wake_up_interruptible(&par->vsync_wait);
+			lcd_frame_done(par, 1);
 			if (vsync_cb_handler)
 				vsync_cb_handler(vsync_cb_arg);
 		}
@@ -939,23 +985,11 @@ static irqreturn_t lcdc_irq_handler_rev01(int irq, void *arg)
 	} else {
 		lcdc_write(stat, LCD_STAT_REG);
 
-		if (stat & LCD_END_OF_FRAME0) {
-			lcdc_write(par->dma_start,
-				   LCD_DMA_FRM_BUF_BASE_ADDR_0_REG);
-			lcdc_write(par->dma_end,
-				   LCD_DMA_FRM_BUF_CEILING_ADDR_0_REG);
-			par->vsync_flag = 1;
-			wake_up_interruptible(&par->vsync_wait);
-		}
+		if (stat & LCD_END_OF_FRAME0)
+			lcd_frame_done(par, 0);
 
-		if (stat & LCD_END_OF_FRAME1) {
-			lcdc_write(par->dma_start,
-				   LCD_DMA_FRM_BUF_BASE_ADDR_1_REG);
-			lcdc_write(par->dma_end,
-				   LCD_DMA_FRM_BUF_CEILING_ADDR_1_REG);
-			par->vsync_flag = 1;
-			wake_up_interruptible(&par->vsync_wait);
-		}
+		if (stat & LCD_END_OF_FRAME1)
+			lcd_frame_done(par, 1);
 	}
 
 	return IRQ_HANDLED;
@@ -1080,6 +1114,8 @@ static int __devexit fb_remove(struct platform_device *dev)
 		lcdc_write(0, LCD_DMA_CTRL_REG);
 
 		unregister_framebuffer(info);
+		if (par->flip_eventfd)
+			eventfd_ctx_put(par->flip_eventfd);
 		fb_dealloc_cmap(&info->cmap);
 		dma_free_coherent(NULL, PALETTE_SIZE, par->v_palette_base,
 				  par->p_palette_base);
@@ -1096,15 +1132,59 @@ static int __devexit fb_remove(struct platform_device *dev)
 	return 0;
 }
 
+/* Complete pending flips at once, once the raster has been stopped */
+static void lcd_flip_flush(struct da8xx_fb_par *par)
+{
+	unsigned long irq_flags;
+	int flips;
+
+	spin_lock_irqsave(&par->lock_for_chan_update, irq_flags);
+	flips = (par->flip_chan >= 0) + par->flip_queued;
+	if (par->flip_queued) {
+		par->dma_start = par->flip_start;
+		par->dma_end = par->flip_end;
+		par->flip_queued = false;
+	}
+	if (flips && par->flip_eventfd)
+		eventfd_signal(par->flip_eventfd, flips);
+	par->flip_chan = -1;
+	lcd_write_dma_addr(par, 0);
+	lcd_write_dma_addr(par, 1);
+	spin_unlock_irqrestore(&par->lock_for_chan_update, irq_flags);
+
+	wake_up_interruptible(&par->flip_wait);
+}
+
+static bool lcd_flip_pending(struct da8xx_fb_par *par)
+{
+	unsigned long irq_flags;
+	bool pending;
+
+	spin_lock_irqsave(&par->lock_for_chan_update, irq_flags);
+	pending = par->flip_chan >= 0 || par->flip_queued;
+	spin_unlock_irqrestore(&par->lock_for_chan_update, irq_flags);
+
+	return pending;
+}
+
 /*
  * Function to wait for vertical sync which for this LCD peripheral
  * translates into waiting for the current raster frame to complete.
+ * If page flips are pending, wait for the vertical sync at which the
+ * last of them reaches the screen instead.
  */
 static int fb_wait_for_vsync(struct fb_info *info)
 {
 	struct da8xx_fb_par *par = info->par;
 	int ret;
 
+	if (lcd_flip_pending(par)) {
+		ret = wait_event_interruptible_timeout(par->flip_wait,
+						!lcd_flip_pending(par),
+						2 * par->vsync_timeout);
+		goto done;
+	}
+
 	/*
 	 * Set flag to 0 and wait for isr to set to 1. It would seem there is a
 	 * race condition here where the ISR could have occurred just before or
@@ -1121,6 +1201,7 @@ static int fb_wait_for_vsync(struct fb_info *info)
 	ret = wait_event_interruptible_timeout(par->vsync_wait,
 					       par->vsync_flag != 0,
 					       par->vsync_timeout);
+done:
 	if (ret < 0)
 		return ret;
 	if (ret == 0)
@@ -1137,10 +1218,32 @@ static int fb_wait_for_vsync(struct fb_info *info)
 	return 0;
 }
 
+static int fb_set_flip_eventfd(struct da8xx_fb_par *par, int fd)
+{
+	struct eventfd_ctx *ctx = NULL, *old;
+	unsigned long irq_flags;
+
+	if (fd >= 0) {
+		ctx = eventfd_ctx_fdget(fd);
+		if (IS_ERR(ctx))
+			return PTR_ERR(ctx);
+	}
+
+	spin_lock_irqsave(&par->lock_for_chan_update, irq_flags);
+	old = par->flip_eventfd;
+	par->flip_eventfd = ctx;
+	spin_unlock_irqrestore(&par->lock_for_chan_update, irq_flags);
+
+	if (old)
+		eventfd_ctx_put(old);
+	return 0;
+}
+
 static int fb_ioctl(struct fb_info *info, unsigned int cmd,
 			  unsigned long arg)
 {
 	struct lcd_sync_arg sync_arg;
+	int fd;
 
 	switch (cmd) {
 	case FBIOGET_CONTRAST:
@@ -1168,6 +1271,10 @@ static int fb_ioctl(struct fb_info *info, unsigned int cmd,
 		break;
 	case FBIO_WAITFORVSYNC:
 		return fb_wait_for_vsync(info);
+	case FBIOSET_FLIP_EVENTFD:
+		if (get_user(fd, (int __user *)arg))
+			return -EFAULT;
+		return fb_set_flip_eventfd(info->par, fd);
 	default:
 		return -EINVAL;
 	}
@@ -1195,6 +1302,7 @@ static int cfb_blank(int blank, struct fb_info *info)
 			par->panel_power_ctrl(0);
 
 		lcd_disable_raster(WAIT_FOR_FRAME_DONE);
+		lcd_flip_flush(par);
 		break;
 	default:
 		ret = -EINVAL;
@@ -1206,6 +1314,11 @@ static int cfb_blank(int blank, struct fb_info *info)
 /*
  * Set new x,y offsets in the virtual display for the visible area and switch
  * to the new mode.
+ *
+ * While the raster is running, the new area is shown from the end of the
+ * frame being scanned out, never in the middle of one.  This never blocks:
+ * if a flip is already armed, the new one is queued behind it, replacing
+ * any flip queued before.
  */
 static int da8xx_pan_display(struct fb_var_screeninfo *var,
 			     struct fb_info *fbi)
@@ -1232,20 +1345,26 @@ static int da8xx_pan_display(struct fb_var_screeninfo *var,
 				new_var.yoffset * fix->line_length +
 				new_var.xoffset * fbi->var.bits_per_pixel / 8;
 			end	= start + fbi->var.yres * fix->line_length - 1;
-			par->dma_start	= start;
-			par->dma_end	= end;
 			spin_lock_irqsave(&par->lock_for_chan_update,
 					irq_flags);
-			if (par->which_dma_channel_done == 0) {
-				lcdc_write(par->dma_start,
-					   LCD_DMA_FRM_BUF_BASE_ADDR_0_REG);
-				lcdc_write(par->dma_end,
-					   LCD_DMA_FRM_BUF_CEILING_ADDR_0_REG);
-			} else if (par->which_dma_channel_done == 1) {
-				lcdc_write(par->dma_start,
-					   LCD_DMA_FRM_BUF_BASE_ADDR_1_REG);
-				lcdc_write(par->dma_end,
-					   LCD_DMA_FRM_BUF_CEILING_ADDR_1_REG);
+			if (par->flip_chan >= 0) {
+				par->flip_start	= start;
+				par->flip_end	= end;
+				par->flip_queued = true;
+			} else {
+				par->dma_start	= start;
+				par->dma_end	= end;
+				par->flip_queued = false;
+				if (par->blank != FB_BLANK_UNBLANK) {
+					/* raster is off, no EOF will come */
+					lcd_write_dma_addr(par, 0);
+					lcd_write_dma_addr(par, 1);
+				} else if (par->which_dma_channel_done >= 0) {
+					lcd_write_dma_addr(par,
+						par->which_dma_channel_done);
+					par->flip_chan =
+						par->which_dma_channel_done;
+				}
 			}
 			spin_unlock_irqrestore(&par->lock_for_chan_update,
 					irq_flags);
@@ -1485,6 +1604,8 @@ static int __devinit fb_probe(struct platform_device *device)
 	par->vsync_timeout = HZ / 5;
 	par->which_dma_channel_done = -1;
 	spin_lock_init(&par->lock_for_chan_update);
+	init_waitqueue_head(&par->flip_wait);
+	par->flip_chan = -1;
 
 	/* Register the Frame Buffer  */
 	if (register_framebuffer(da8xx_fb_info) < 0) {
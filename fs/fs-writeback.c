@@ -25,6 +25,7 @@
 #include <linux/writeback.h>
 #include <linux/blkdev.h>
 #include <linux/backing-dev.h>
+#include <linux/memcontrol.h>
 #include <linux/buffer_head.h>
 #include <linux/tracepoint.h>
 #include "internal.h"
@@ -41,6 +42,8 @@ struct wb_writeback_work {
 	unsigned int for_kupdate:1;
 	unsigned int range_cyclic:1;
 	unsigned int for_background:1;
+	unsigned int memcg_fallback:1;	/* memcg_id only stops writeback */
+	unsigned short memcg_id;	/* only inodes dirtied by this memcg */
 	enum wb_reason reason;		/* why was writeback initiated? */
 
 	struct list_head list;		/* pending work list */
@@ -182,6 +185,46 @@ void bdi_start_background_writeback(struct backing_dev_info *bdi)
 	spin_unlock_bh(&bdi->wb_lock);
 }
 
+/**
+ * bdi_start_memcg_writeback - start background writeback for a memory cgroup
+ * @bdi: the backing device to write from
+ * @memcg_id: css id of the memory cgroup over its background threshold
+ *
+ * Description:
+ *   Like bdi_start_background_writeback(), but only the inodes dirtied by
+ *   the memory cgroup (or its descendants) are written, until the cgroup
+ *   gets below its own background dirty threshold.  If none of those can
+ *   be written, any inode of @bdi is, with the same stop condition.
+ */
+void bdi_start_memcg_writeback(struct backing_dev_info *bdi,
+			       unsigned short memcg_id)
+{
+	struct wb_writeback_work *work;
+
+	/* Throttled writers call in here often, queue one work per cgroup */
+	spin_lock_bh(&bdi->wb_lock);
+	list_for_each_entry(work, &bdi->work_list, list) {
+		if (work->memcg_id == memcg_id) {
+			spin_unlock_bh(&bdi->wb_lock);
+			return;
+		}
+	}
+	spin_unlock_bh(&bdi->wb_lock);
+
+	work = kzalloc(sizeof(*work), GFP_ATOMIC);
+	if (!work)
+		return;
+
+	work->sync_mode	= WB_SYNC_NONE;
+	work->nr_pages	= LONG_MAX;
+	work->range_cyclic = 1;
+	work->for_background = 1;
+	work->memcg_id	= memcg_id;
+	work->reason	= WB_REASON_MEMCG_BACKGROUND;
+
+	bdi_queue_work(bdi, work);
+}
+
 /*
  * Remove the inode from the writeback list it is on.
  */
@@ -564,6 +607,16 @@ static long writeback_sb_inodes(struct super_block *sb,
 			break;
 		}
 
+		/*
+		 * Writeback on behalf of a memory cgroup leaves the inodes
+		 * of the other cgroups for later.
+		 */
+		if (work->memcg_id && !work->memcg_fallback &&
+		    !mem_cgroup_inode_dirtied_by(inode, work->memcg_id)) {
+			requeue_io(inode, wb);
+			continue;
+		}
+
 		/*
 		 * Don't bother with new inodes or inodes beeing freed, first
 		 * kind does not need peridic writeout yet, and for the latter
@@ -665,10 +718,14 @@ long writeback_inodes_wb(struct bdi_writeback *wb, long nr_pages,
 	return nr_pages - work.nr_pages;
 }
 
-static bool over_bground_thresh(struct backing_dev_info *bdi)
+static bool over_bground_thresh(struct backing_dev_info *bdi,
+				unsigned short memcg_id)
 {
 	unsigned long background_thresh, dirty_thresh;
 
+	if (memcg_id)
+		return mem_cgroup_over_bground_thresh(memcg_id);
+
 	global_dirty_limits(&background_thresh, &dirty_thresh);
 
 	if (global_page_state(NR_FILE_DIRTY) +
@@ -741,7 +798,8 @@ static long wb_writeback(struct bdi_writeback *wb,
 		 * For background writeout, stop when we are below the
 		 * background dirty threshold
 		 */
-		if (work->for_background && !over_bground_thresh(wb->bdi))
+		if (work->for_background &&
+		    !over_bground_thresh(wb->bdi, work->memcg_id))
 			break;
 
 		if (work->for_kupdate) {
@@ -771,6 +829,16 @@ static long wb_writeback(struct bdi_writeback *wb,
 		 */
 		if (progress)
 			continue;
+		/*
+		 * A memory cgroup's dirty pages may sit in inodes which were
+		 * last dirtied by another cgroup.  If none of its own inodes
+		 * could be written, write any inode of the bdi until the
+		 * cgroup is below its background threshold again.
+		 */
+		if (work->memcg_id && !work->memcg_fallback) {
+			work->memcg_fallback = 1;
+			continue;
+		}
 		/*
 		 * No more inodes for IO, bail
 		 */
@@ -825,7 +893,7 @@ static unsigned long get_nr_dirty_pages(void)
 
 static long wb_check_background_flush(struct bdi_writeback *wb)
 {
-	if (over_bground_thresh(wb->bdi)) {
+	if (over_bground_thresh(wb->bdi, 0)) {
 
 		struct wb_writeback_work work = {
 			.nr_pages	= LONG_MAX,
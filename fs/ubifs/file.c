@@ -46,7 +46,9 @@
  * Similarly, @i_mutex is not always locked in 'ubifs_readpage()', e.g., the
  * read-ahead path does not lock it ("sys_read -> generic_file_aio_read ->
  * ondemand_readahead -> readpage"). In case of readahead, @I_SYNC flag is not
- * set as well. However, UBIFS disables readahead.
+ * set as well. UBIFS keeps read-ahead off by default (@c->bdi.ra_pages is 0),
+ * but if it is switched on via sysfs, pages arrive through 'ubifs_readpages()'
+ * without @i_mutex as well.
  */
 
 #include "ubifs.h"
@@ -808,6 +810,60 @@ out_bu_off:
 	goto out_free;
 }
 
+/**
+ * bulk_read_page - bulk-read starting from a page.
+ * @c: UBIFS file-system description object
+ * @page: page from which to start bulk-read
+ *
+ * This is a helper for 'ubifs_bulk_read()' and 'ubifs_readahead_page()' which
+ * sets up bulk-read information and does the bulk-read. If @may_alloc is
+ * zero, only the pre-allocated bulk-read buffer is used and nothing is done
+ * if it is busy. The caller has to hold @ui->ui_mutex. Returns %1 if a
+ * bulk-read is done and %0 otherwise.
+ */
+static int bulk_read_page(struct ubifs_info *c, struct page *page,
+			  int may_alloc)
+{
+	struct inode *inode = page->mapping->host;
+	struct bu_info *bu = NULL;
+	int err, allocated = 0;
+
+	/*
+	 * If possible, try to use pre-allocated bulk-read information, which
+	 * is protected by @c->bu_mutex. It is only allocated if bulk-read is
+	 * enabled.
+	 */
+	if (mutex_trylock(&c->bu_mutex)) {
+		if (c->bu.buf)
+			bu = &c->bu;
+		else
+			mutex_unlock(&c->bu_mutex);
+	}
+
+	if (!bu) {
+		if (!may_alloc)
+			return 0;
+		bu = kmalloc(sizeof(struct bu_info), GFP_NOFS | __GFP_NOWARN);
+		if (!bu)
+			return 0;
+
+		bu->buf = NULL;
+		allocated = 1;
+	}
+
+	bu->buf_len = c->max_bu_buf_len;
+	data_key_init(c, &bu->key, inode->i_ino,
+		      page->index << UBIFS_BLOCKS_PER_PAGE_SHIFT);
+	err = ubifs_do_bulk_read(c, bu, page);
+
+	if (!allocated)
+		mutex_unlock(&c->bu_mutex);
+	else
+		kfree(bu);
+
+	return err;
+}
+
 /**
  * ubifs_bulk_read - determine whether to bulk-read and, if so, do it.
  * @page: page from which to start bulk-read.
@@ -823,8 +879,7 @@ static int ubifs_bulk_read(struct page *page)
 	struct ubifs_info *c = inode->i_sb->s_fs_info;
 	struct ubifs_inode *ui = ubifs_inode(inode);
 	pgoff_t index = page->index, last_page_read = ui->last_page_read;
-	struct bu_info *bu;
-	int err = 0, allocated = 0;
+	int err = 0;
 
 	ui->last_page_read = index;
 	if (!c->bulk_read)
@@ -853,30 +908,7 @@ static int ubifs_bulk_read(struct page *page)
 		ui->bulk_read = 1;
 	}
 
-	/*
-	 * If possible, try to use pre-allocated bulk-read information, which
-	 * is protected by @c->bu_mutex.
-	 */
-	if (mutex_trylock(&c->bu_mutex))
-		bu = &c->bu;
-	else {
-		bu = kmalloc(sizeof(struct bu_info), GFP_NOFS | __GFP_NOWARN);
-		if (!bu)
-			goto out_unlock;
-
-		bu->buf = NULL;
-		allocated = 1;
-	}
-
-	bu->buf_len = c->max_bu_buf_len;
-	data_key_init(c, &bu->key, inode->i_ino,
-		      page->index << UBIFS_BLOCKS_PER_PAGE_SHIFT);
-	err = ubifs_do_bulk_read(c, bu, page);
-
-	if (!allocated)
-		mutex_unlock(&c->bu_mutex);
-	else
-		kfree(bu);
+	err = bulk_read_page(c, page, 1);
 
 out_unlock:
 	mutex_unlock(&ui->ui_mutex);
@@ -892,6 +924,87 @@ static int ubifs_readpage(struct file *file, struct page *page)
 	return 0;
 }
 
+/**
+ * ubifs_readahead_page - read a page the VM asked to read ahead.
+ * @page: the page to read, locked and in the page cache
+ *
+ * Read-ahead means the VM has already detected sequential access, so unlike
+ * 'ubifs_readpage()' this function does not wait for three reads in a row.
+ * If the "bulk_read" mount option is set, it tries to read @page and the
+ * following pages with one TNC look-up and one LEB read, using the
+ * pre-allocated bulk-read buffer. Otherwise, or if that buffer is busy, only
+ * @page is read. The page is unlocked on return.
+ */
+static void ubifs_readahead_page(struct page *page)
+{
+	struct inode *inode = page->mapping->host;
+	struct ubifs_info *c = inode->i_sb->s_fs_info;
+	struct ubifs_inode *ui = ubifs_inode(inode);
+	int done = 0;
+
+	/* See the comment in 'ubifs_bulk_read()' */
+	if (c->bulk_read && mutex_trylock(&ui->ui_mutex)) {
+		ui->last_page_read = page->index;
+		done = bulk_read_page(c, page, 0);
+		mutex_unlock(&ui->ui_mutex);
+	}
+
+	if (!done) {
+		do_readpage(page);
+		unlock_page(page);
+	}
+}
+
+/**
+ * readahead_mark_cached - move the read-ahead marker to the cached page.
+ * @mapping: address space the read-ahead is for
+ * @page: our copy of the page, which could not be added to @mapping
+ *
+ * The VM marks one page of each read-ahead run with PG_readahead, to start
+ * the next run when it is read. If bulk-read already put that page into the
+ * page cache, our copy is dropped, so set the marker on the cached page.
+ */
+static void readahead_mark_cached(struct address_space *mapping,
+				  struct page *page)
+{
+	struct page *cached;
+
+	if (!PageReadahead(page))
+		return;
+
+	cached = find_get_page(mapping, page->index);
+	if (!cached)
+		return;
+	/* PG_readahead is PG_reclaim on pages under write-back */
+	if (!PageWriteback(cached))
+		SetPageReadahead(cached);
+	page_cache_release(cached);
+}
+
+/*
+ * Pages for read-ahead are read in ascending order. With bulk-read, the first
+ * page of each run also adds the following pages to the page cache, so when
+ * we get to them, 'add_to_page_cache_lru()' fails with %-EEXIST and we just
+ * drop our copy.
+ */
+static int ubifs_readpages(struct file *file, struct address_space *mapping,
+			   struct list_head *pages, unsigned nr_pages)
+{
+	while (!list_empty(pages)) {
+		struct page *page = list_entry(pages->prev, struct page, lru);
+
+		list_del(&page->lru);
+		if (!add_to_page_cache_lru(page, mapping, page->index,
+					   GFP_NOFS))
+			ubifs_readahead_page(page);
+		else
+			readahead_mark_cached(mapping, page);
+		page_cache_release(page);
+	}
+
+	return 0;
+}
+
 static int do_writepage(struct page *page, int len)
 {
 	int err = 0, i, blen;
@@ -1551,6 +1664,7 @@ static int ubifs_file_mmap(struct file *file, struct vm_area_struct *vma)
 
 const struct address_space_operations ubifs_file_address_operations = {
 	.readpage       = ubifs_readpage,
+	.readpages      = ubifs_readpages,
 	.writepage      = ubifs_writepage,
 	.write_begin    = ubifs_write_begin,
 	.write_end      = ubifs_write_end,
@@ -1883,6 +1883,8 @@ static int ubifs_remount_fs(struct super_block *sb, int *flags, char *data)
 		ubifs_remount_ro(c);
 	}
 
+	/* Read-ahead may be using the bulk-read buffer */
+	mutex_lock(&c->bu_mutex);
 	if (c->bulk_read == 1)
 		bu_init(c);
 	else {
@@ -1890,6 +1892,7 @@ static int ubifs_remount_fs(struct super_block *sb, int *flags, char *data)
 		kfree(c->bu.buf);
 		c->bu.buf = NULL;
 	}
+	mutex_unlock(&c->bu_mutex);
 
 	ubifs_assert(c->lst.taken_empty_lebs > 0);
 	return 0;
@@ -17,6 +17,7 @@
 #include <linux/timer.h>
 #include <linux/writeback.h>
 #include <linux/atomic.h>
+#include <linux/math64.h>
 
 struct page;
 struct device;
@@ -42,9 +43,17 @@ enum bdi_stat_item {
 	BDI_WRITEBACK,
 	BDI_DIRTIED,
 	BDI_WRITTEN,
+	BDI_RA_PAGES,		/* pages submitted by readahead */
+	BDI_RA_HIT,		/* readahead windows reached in time */
+	BDI_RA_MISS,		/* sequential reads not covered by readahead */
+	BDI_RA_WAIT,		/* reads that waited for readahead I/O */
+	BDI_RA_WAIT_US,		/* time spent in those waits */
+	BDI_RA_THRASH,		/* readahead pages reclaimed before use */
 	NR_BDI_STAT_ITEMS
 };
 
+#define NR_BDI_RA_ITEMS	(NR_BDI_STAT_ITEMS - BDI_RA_PAGES)
+
 #define BDI_STAT_BATCH (8*(1+ilog2(nr_cpu_ids)))
 
 struct bdi_writeback {
@@ -89,6 +98,20 @@ struct backing_dev_info {
 	unsigned long dirty_ratelimit;
 	unsigned long balanced_dirty_ratelimit;
 
+	/*
+	 * Adaptive readahead: when enabled, the readahead window of all
+	 * files on the device is @ra_window, re-evaluated every 200ms from
+	 * the BDI_RA_* counters, see bdi_update_readahead().
+	 */
+	unsigned int ra_adaptive;
+	unsigned int ra_grown;		/* window was grown last period */
+	unsigned long ra_window;	/* current window, in pages */
+	unsigned long ra_max_pages;	/* upper bound of @ra_window */
+	unsigned long ra_time_stamp;	/* last time the window was updated */
+	unsigned long ra_wait_avg;	/* us per wait, last grown period */
+	s64 ra_stamp[NR_BDI_RA_ITEMS];	/* BDI_RA_* at ra_time_stamp */
+	spinlock_t ra_lock;
+
 	struct prop_local_percpu completions;
 	int dirty_exceeded;
 
@@ -121,6 +144,8 @@ int bdi_setup_and_register(struct backing_dev_info *, char *, unsigned int);
 void bdi_start_writeback(struct backing_dev_info *bdi, long nr_pages,
 			enum wb_reason reason);
 void bdi_start_background_writeback(struct backing_dev_info *bdi);
+void bdi_start_memcg_writeback(struct backing_dev_info *bdi,
+			       unsigned short memcg_id);
 int bdi_writeback_thread(void *data);
 int bdi_has_dirty_io(struct backing_dev_info *bdi);
 void bdi_arm_supers_timer(void);
@@ -202,6 +227,21 @@ static inline s64 bdi_stat_sum(struct backing_dev_info *bdi,
 }
 
 extern void bdi_writeout_inc(struct backing_dev_info *bdi);
+extern void bdi_update_readahead(struct backing_dev_info *bdi);
+extern void bdi_set_readahead_adaptive(struct backing_dev_info *bdi,
+				       int adaptive);
+extern unsigned long bdi_readahead_hit_ratio(struct backing_dev_info *bdi);
+
+/*
+ * A reader waited since @start (local_clock() time) for a page that was
+ * still being read ahead.
+ */
+static inline void bdi_readahead_wait(struct backing_dev_info *bdi, u64 start)
+{
+	__inc_bdi_stat(bdi, BDI_RA_WAIT);
+	__add_bdi_stat(bdi, BDI_RA_WAIT_US,
+		       div_u64(local_clock() - start, NSEC_PER_USEC));
+}
 
 /*
  * maximal error of a stat counter.
@@ -0,0 +1,80 @@
+#ifndef __LINUX_CMA_H
+#define __LINUX_CMA_H
+
+/*
+ * Contiguous Memory Allocator for DMA mapping framework
+ *
+ * A contiguous memory area is reserved with memblock early during boot.
+ * Its pageblocks are handed to the page allocator as MIGRATE_CMA, so the
+ * memory serves movable allocations (page cache, anonymous pages) while
+ * no driver needs it.  When a driver asks for a contiguous buffer, the
+ * pages in the requested range are migrated away and the range is
+ * returned as a whole.
+ *
+ * An area is either the global default one, sized by CONFIG_CMA_SIZE_MBYTES
+ * or the "cma=" kernel parameter, or a private one declared by platform
+ * code for a particular device with dma_declare_contiguous().
+ *
+ * Architecture code calls dma_contiguous_reserve() from its memblock setup
+ * and dma_alloc_from_contiguous()/dma_release_from_contiguous() from its
+ * dma_alloc_coherent() implementation.  Drivers keep using the usual DMA
+ * mapping API.
+ */
+
+#ifdef __KERNEL__
+
+struct cma;
+struct page;
+struct device;
+
+#ifdef CONFIG_CMA
+
+/*
+ * There is always at least global CMA area and a few optional device
+ * private areas configured in kernel .config.
+ */
+#define MAX_CMA_AREAS	(1 + CONFIG_CMA_AREAS)
+
+extern struct cma *dma_contiguous_default_area;
+
+void dma_contiguous_reserve(phys_addr_t addr_limit);
+int dma_declare_contiguous(struct device *dev, unsigned long size,
+			   phys_addr_t base, phys_addr_t limit);
+
+struct page *dma_alloc_from_contiguous(struct device *dev, int count,
+				       unsigned int order);
+bool dma_release_from_contiguous(struct device *dev, struct page *pages,
+				 int count);
+
+#else
+
+#define MAX_CMA_AREAS	(0)
+
+static inline void dma_contiguous_reserve(phys_addr_t limit) { }
+
+static inline
+int dma_declare_contiguous(struct device *dev, unsigned long size,
+			   phys_addr_t base, phys_addr_t limit)
+{
+	return -ENOSYS;
+}
+
+static inline
+struct page *dma_alloc_from_contiguous(struct device *dev, int count,
+				       unsigned int order)
+{
+	return NULL;
+}
+
+static inline
+bool dma_release_from_contiguous(struct device *dev, struct page *pages,
+				 int count)
+{
+	return false;
+}
+
+#endif
+
+#endif
+
+#endif
@@ -367,6 +367,16 @@ void drain_zone_pages(struct zone *zone, struct per_cpu_pages *pcp);
 void drain_all_pages(void);
 void drain_local_pages(void *dummy);
 
+#ifdef CONFIG_CMA
+/* The below functions must be run on a range from a single zone. */
+extern int alloc_contig_range(unsigned long start, unsigned long end,
+			      int migratetype);
+extern void free_contig_range(unsigned long pfn, unsigned long nr_pages);
+
+/* CMA stuff */
+extern void init_cma_reserved_pageblock(struct page *page);
+#endif
+
 extern gfp_t gfp_allowed_mask;
 
 extern void pm_restrict_gfp_mask(void);
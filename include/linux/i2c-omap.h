@@ -35,6 +35,7 @@ struct omap_i2c_bus_platform_data {
 	u32		clkrate;
 	u32		rev;
 	u32		flags;
+	u32		irq_thread_prio;	/* SCHED_FIFO, 0 for default */
 	void		(*set_mpu_wkup_lat)(struct device *dev, long set);
 	int		(*device_reset) (struct device *dev);
 };
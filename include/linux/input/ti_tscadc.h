@@ -12,6 +12,9 @@
  *			YNLR = AN3, then set this variable to
  *			0.
  * @x_plate_resistance:	X plate resistance.
+ * @mode:		TI_TSCADC_TSCMODE or TI_TSCADC_GENMODE.
+ * @irq_thread_prio:	SCHED_FIFO priority of the interrupt thread,
+ *			0 to keep the default.
  */
 #include <linux/device.h>
 
@@ -23,4 +26,5 @@ struct tsc_data {
 	int analog_input;
 	int x_plate_resistance;
 	int mode;
+	int irq_thread_prio;
 };
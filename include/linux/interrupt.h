@@ -145,6 +145,8 @@ extern int __must_check
 request_percpu_irq(unsigned int irq, irq_handler_t handler,
 		   const char *devname, void __percpu *percpu_dev_id);
 
+extern int irq_set_thread_priority(unsigned int irq, void *dev_id, int prio);
+
 extern void exit_irq_thread(void);
 #else
 
@@ -180,6 +182,12 @@ request_percpu_irq(unsigned int irq, irq_handler_t handler,
 	return request_irq(irq, handler, 0, devname, percpu_dev_id);
 }
 
+static inline int
+irq_set_thread_priority(unsigned int irq, void *dev_id, int prio)
+{
+	return -ENOSYS;
+}
+
 static inline void exit_irq_thread(void) { }
 #endif
 
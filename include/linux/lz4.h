@@ -0,0 +1,45 @@
+#ifndef __LZ4_H__
+#define __LZ4_H__
+/*
+ *  LZ4 Public Kernel Interface
+ *
+ *  LZ4 is a byte oriented LZ77 coder without entropy stage.  It trades
+ *  some compression ratio against LZO for noticeably faster compression
+ *  and decompression.  The block format is compatible with the
+ *  reference implementation at http://code.google.com/p/lz4/
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ */
+
+#include <linux/types.h>
+
+#define LZ4_HASH_LOG		12
+#define LZ4_MEM_COMPRESS	((1 << LZ4_HASH_LOG) * sizeof(u32))
+
+#define lz4_compressbound(x)	((x) + ((x) / 255) + 16)
+
+/*
+ * This requires 'wrkmem' of size LZ4_MEM_COMPRESS and 'dst' of at
+ * least lz4_compressbound(src_len) bytes.
+ */
+int lz4_compress(const unsigned char *src, size_t src_len,
+		unsigned char *dst, size_t *dst_len, void *wrkmem);
+
+/*
+ * Safe decompression with overrun testing: on entry *dst_len is the
+ * size of 'dst', on return the number of bytes decompressed.
+ */
+int lz4_decompress_safe(const unsigned char *src, size_t src_len,
+		unsigned char *dst, size_t *dst_len);
+
+/*
+ * Return values (< 0 = Error)
+ */
+#define LZ4_E_OK		0
+#define LZ4_E_INPUT_OVERRUN	(-1)
+#define LZ4_E_OUTPUT_OVERRUN	(-2)
+#define LZ4_E_LOOKBEHIND_OVERRUN	(-3)
+
+#endif
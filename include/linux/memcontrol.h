@@ -26,10 +26,25 @@ struct mem_cgroup;
 struct page_cgroup;
 struct page;
 struct mm_struct;
+struct inode;
 
 /* Stats that can be updated by kernel. */
 enum mem_cgroup_page_stat_item {
 	MEMCG_NR_FILE_MAPPED, /* # of pages charged as file rss */
+	MEMCG_NR_FILE_DIRTY, /* # of dirty pages in page cache */
+	MEMCG_NR_FILE_WRITEBACK, /* # of pages under writeback */
+};
+
+/*
+ * Dirty page limits of a memory cgroup and its dirty page counts, all in
+ * pages.  See mem_cgroup_dirty_info().
+ */
+struct mem_cgroup_dirty_info {
+	unsigned long dirty_thresh;
+	unsigned long background_thresh;
+	unsigned long nr_dirty;
+	unsigned long nr_writeback;
+	unsigned short memcg_id;	/* css id of the cgroup */
 };
 
 extern unsigned long mem_cgroup_isolate_pages(unsigned long nr_to_scan,
@@ -149,6 +164,10 @@ static inline void mem_cgroup_dec_page_stat(struct page *page,
 	mem_cgroup_update_page_stat(page, idx, -1);
 }
 
+bool mem_cgroup_dirty_info(struct mem_cgroup_dirty_info *info);
+bool mem_cgroup_over_bground_thresh(unsigned short memcg_id);
+bool mem_cgroup_inode_dirtied_by(struct inode *inode, unsigned short memcg_id);
+
 unsigned long mem_cgroup_soft_limit_reclaim(struct zone *zone, int order,
 						gfp_t gfp_mask,
 						unsigned long *total_scanned);
@@ -345,6 +364,22 @@ static inline void mem_cgroup_dec_page_stat(struct page *page,
 {
 }
 
+static inline bool mem_cgroup_dirty_info(struct mem_cgroup_dirty_info *info)
+{
+	return false;
+}
+
+static inline bool mem_cgroup_over_bground_thresh(unsigned short memcg_id)
+{
+	return false;
+}
+
+static inline bool mem_cgroup_inode_dirtied_by(struct inode *inode,
+					       unsigned short memcg_id)
+{
+	return true;
+}
+
 static inline
 unsigned long mem_cgroup_soft_limit_reclaim(struct zone *zone, int order,
 					    gfp_t gfp_mask,
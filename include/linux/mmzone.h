@@ -41,7 +41,19 @@
 #define MIGRATE_PCPTYPES      3 /* the number of types on the pcp lists */
 #define MIGRATE_RESERVE       3
 #define MIGRATE_ISOLATE       4 /* can't allocate from here */
+#ifdef CONFIG_CMA
+/*
+ * Pageblocks of a contiguous memory area.  Only movable allocations fall
+ * back to them and they are never claimed by another type, so their
+ * pages can always be migrated away when the area is allocated from.
+ */
+#define MIGRATE_CMA           5
+#define MIGRATE_TYPES         6
+#define is_migrate_cma(type)  unlikely((type) == MIGRATE_CMA)
+#else
 #define MIGRATE_TYPES         5
+#define is_migrate_cma(type)  false
+#endif
 
 #define for_each_migratetype_order(order, type) \
 	for (order = 0; order < MAX_ORDER; order++) \
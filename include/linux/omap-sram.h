@@ -0,0 +1,28 @@
+/*
+ * OMAP on-chip SRAM user interface
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#ifndef __OMAP_SRAM_H__
+#define __OMAP_SRAM_H__
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+/*
+ * /dev/omap-sram hands out one SRAM buffer per open file.
+ * OMAP_SRAM_IOC_ALLOC allocates size bytes, rounded up to a page, and
+ * returns the physical address of the buffer in phys, e.g. for a DMA
+ * master or PRU firmware.  mmap() at offset 0 then maps it uncached.
+ * The buffer is freed when the file is closed and no mapping remains.
+ */
+struct omap_sram_req {
+	__u32	size;
+	__u32	phys;
+};
+
+#define OMAP_SRAM_IOC_ALLOC	_IOWR(0xEB, 1, struct omap_sram_req)
+
+#endif /* __OMAP_SRAM_H__ */
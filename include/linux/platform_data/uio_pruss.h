@@ -18,8 +18,15 @@
 #ifndef _UIO_PRUSS_H_
 #define _UIO_PRUSS_H_
 
-/* To configure the PRUSS INTC base offset for UIO driver */
+/*
+ * To configure the PRUSS INTC base offset for UIO driver.  The PRU control
+ * register and instruction RAM offsets are needed for loading firmware from
+ * the kernel; leave pru_iram_size zero if that is not supported.
+ */
 struct uio_pruss_pdata {
 	u32	pintc_base;
+	u32	pru_ctrl_base[2];
+	u32	pru_iram_base[2];
+	u32	pru_iram_size;
 };
 #endif /* _UIO_PRUSS_H_ */
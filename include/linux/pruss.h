@@ -0,0 +1,74 @@
+/*
+ * include/linux/pruss.h
+ *
+ * In-kernel interface to the Programmable Real-Time Unit Sub System (PRUSS)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef _LINUX_PRUSS_H_
+#define _LINUX_PRUSS_H_
+
+#include <linux/types.h>
+#include <linux/err.h>
+
+struct uio_pruss_dev;
+
+/*
+ * Shared memory message ring between the ARM and a PRU core.
+ *
+ * The ring lives in a DMA coherent buffer both sides can reach and has
+ * exactly one producer and one consumer, so no locking is needed between
+ * them.  head and tail are free running byte counters: the producer only
+ * writes head, the consumer only writes tail.  Each message is a 32-bit
+ * length followed by the payload, padded to a multiple of 4 bytes;
+ * messages may wrap around the end of data[].
+ * PRU firmware must use the same layout.
+ */
+struct pruss_ring_hdr {
+	u32	head;
+	u32	tail;
+	u32	size;		/* bytes in data[], a power of 2 */
+	u32	reserved;
+	u8	data[0];
+};
+
+struct pruss_ring {
+	struct pruss_ring_hdr	*hdr;
+	u32			size;
+};
+
+typedef void (*pruss_event_handler_t)(int evtout, void *data);
+
+#if defined(CONFIG_UIO_PRUSS) || defined(CONFIG_UIO_PRUSS_MODULE)
+struct uio_pruss_dev *pruss_get(void);
+void pruss_put(struct uio_pruss_dev *gdev);
+
+int pruss_boot(struct uio_pruss_dev *gdev, int pru, const char *fw_name);
+void pruss_halt(struct uio_pruss_dev *gdev, int pru);
+
+void pruss_send_event(struct uio_pruss_dev *gdev, unsigned int sysevent);
+void pruss_clear_event(struct uio_pruss_dev *gdev, unsigned int sysevent);
+int pruss_request_event(struct uio_pruss_dev *gdev, int evtout,
+			pruss_event_handler_t handler, void *data);
+void pruss_free_event(struct uio_pruss_dev *gdev, int evtout);
+
+int pruss_ring_init(struct pruss_ring *ring, void *mem, size_t len);
+int pruss_ring_attach(struct pruss_ring *ring, void *mem, size_t len);
+int pruss_ring_write(struct pruss_ring *ring, const void *buf, size_t len);
+int pruss_ring_read(struct pruss_ring *ring, void *buf, size_t len);
+bool pruss_ring_empty(struct pruss_ring *ring);
+#else
+static inline struct uio_pruss_dev *pruss_get(void)
+{
+	return ERR_PTR(-ENODEV);
+}
+
+static inline void pruss_put(struct uio_pruss_dev *gdev)
+{
+}
+#endif
+
+#endif /* _LINUX_PRUSS_H_ */
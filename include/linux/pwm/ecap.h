@@ -0,0 +1,38 @@
+/*
+ * eCAP input capture interface
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#ifndef __ECAP_H__
+#define __ECAP_H__
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+/*
+ * Each eCAP instance that has an interrupt line is also exposed as a
+ * character device, /dev/ecapN.  Opening it switches the module from
+ * APWM output to input capture; read() then returns an array of
+ * struct ecap_capture_event, one per captured edge, oldest first.
+ *
+ * timestamp is in ticks of the eCAP functional clock (see
+ * ECAPIOC_GET_TICK_HZ), extended to 64 bits by the driver.  lost counts
+ * the events dropped since the previous returned event because the
+ * FIFO or the hardware capture registers overflowed.
+ */
+struct ecap_capture_event {
+	__u64	timestamp;
+	__u32	edge;
+	__u32	lost;
+};
+
+#define ECAP_EDGE_RISING	1
+#define ECAP_EDGE_FALLING	2
+#define ECAP_EDGE_BOTH		(ECAP_EDGE_RISING | ECAP_EDGE_FALLING)
+
+#define ECAPIOC_SET_EDGES	_IOW(0xEC, 1, __u32)
+#define ECAPIOC_GET_TICK_HZ	_IOR(0xEC, 2, __u32)
+
+#endif /* __ECAP_H__ */
@@ -47,6 +47,7 @@ struct ehrpwm_pwm {
 	void __iomem *config_mem_base;
 	struct device *dev;
 	struct ehrpwm_context ctx;
+	unsigned int mep_sf;
 };
 
 enum tz_event {
@@ -66,6 +67,19 @@ enum db_edge_delay {
 	FALLING_EDGE_DELAY,
 };
 
+/*
+ * One channel of an ehrpwm_sync_update() call. Ticks are in units of the
+ * channel's tick_hz; period_ticks of 0 leaves the period unchanged and
+ * duty_frac adds a fraction of a tick (1/65536 units) on channel A when
+ * the high resolution module can be used.
+ */
+struct ehrpwm_update {
+	struct pwm_device *p;
+	unsigned long period_ticks;
+	unsigned long duty_ticks;
+	unsigned int duty_frac;
+};
+
 struct aq_config_params {
 	unsigned char ch;
 	unsigned char ctreqzro;
@@ -174,6 +188,15 @@ int ehrpwm_hr_set_cmpval(struct pwm_device *p, unsigned char val);
 int ehrpwm_hr_config(struct pwm_device *p, unsigned char loadmode,
 		unsigned char ctlmode, unsigned char edgemode);
 
+int ehrpwm_hr_set_mep_scale(struct pwm_device *p, unsigned int steps);
+
+int ehrpwm_hr_set_duty(struct pwm_device *p, unsigned long duty_ticks,
+		unsigned int frac);
+
+int ehrpwm_sync_group_init(struct pwm_device **p, unsigned int n);
+
+int ehrpwm_sync_update(struct ehrpwm_update *upd, unsigned int n);
+
 int ehrpwm_et_cb_register(struct pwm_device *p, void *data,
 	p_fcallback cb);
 
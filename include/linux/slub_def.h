@@ -38,14 +38,26 @@ enum stat_item {
 	CMPXCHG_DOUBLE_FAIL,	/* Number of times that cmpxchg double did not match */
 	CPU_PARTIAL_ALLOC,	/* Used cpu partial on alloc */
 	CPU_PARTIAL_FREE,	/* USed cpu partial on free */
+	ALLOC_MAGAZINE,		/* Allocation from the cpu magazine */
+	FREE_MAGAZINE,		/* Free to the cpu magazine */
 	NR_SLUB_STAT_ITEMS };
 
+/*
+ * Upper bound for the number of objects a cpu magazine can hold.  The
+ * magazine only exists on uniprocessor kernels.
+ */
+#define SLUB_MAGAZINE_SIZE 16
+
 struct kmem_cache_cpu {
 	void **freelist;	/* Pointer to next available object */
 	unsigned long tid;	/* Globally unique transaction id */
 	struct page *page;	/* The slab from which we are allocating */
 	struct page *partial;	/* Partially allocated frozen slabs */
 	int node;		/* The node of the page (or -1 for debug) */
+#ifndef CONFIG_SMP
+	int nr_magazine;	/* Objects in the magazine */
+	void *magazine[SLUB_MAGAZINE_SIZE];	/* Recently freed objects */
+#endif
 #ifdef CONFIG_SLUB_STATS
 	unsigned stat[NR_SLUB_STAT_ITEMS];
 #endif
@@ -83,6 +95,9 @@ struct kmem_cache {
 	int objsize;		/* The size of an object without meta data */
 	int offset;		/* Free pointer offset. */
 	int cpu_partial;	/* Number of per cpu partial objects to keep around */
+#ifndef CONFIG_SMP
+	int cpu_magazine;	/* Number of freed objects to keep in the magazine */
+#endif
 	struct kmem_cache_order_objects oo;
 
 	/* Allocation and freeing of slabs */
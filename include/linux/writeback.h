@@ -50,6 +50,7 @@ enum wb_reason {
 	WB_REASON_FREE_MORE_MEM,
 	WB_REASON_FS_FREE_SPACE,
 	WB_REASON_FORKER_THREAD,
+	WB_REASON_MEMCG_BACKGROUND,
 
 	WB_REASON_MAX,
 };
@@ -103,6 +103,8 @@ struct lcd_sync_arg {
 #define FBIPUT_COLOR		_IOW('F', 6, int)
 #define FBIPUT_HSYNC		_IOW('F', 9, int)
 #define FBIPUT_VSYNC		_IOW('F', 10, int)
+/* eventfd signalled for each page flip that reaches the screen, -1 to clear */
+#define FBIOSET_FLIP_EVENTFD	_IOW('F', 11, int)
 
 typedef void (*vsync_callback_t)(void *arg);
 int register_vsync_cb(vsync_callback_t handler, void *arg, int idx);
@@ -764,9 +764,6 @@ static irqreturn_t irq_thread_fn(struct irq_desc *desc,
  */
 static int irq_thread(void *data)
 {
-	static const struct sched_param param = {
-		.sched_priority = MAX_USER_RT_PRIO/2,
-	};
 	struct irqaction *action = data;
 	struct irq_desc *desc = irq_to_desc(action->irq);
 	irqreturn_t (*handler_fn)(struct irq_desc *desc,
@@ -779,7 +776,6 @@ static int irq_thread(void *data)
 	else
 		handler_fn = irq_thread_fn;
 
-	sched_setscheduler(current, SCHED_FIFO, &param);
 	current->irqaction = action;
 
 	while (!irq_wait_for_interrupt(action)) {
@@ -935,6 +931,9 @@ __setup_irq(unsigned int irq, struct irq_desc *desc, struct irqaction *new)
 	 * thread.
 	 */
 	if (new->thread_fn && !nested) {
+		static const struct sched_param param = {
+			.sched_priority = MAX_USER_RT_PRIO/2,
+		};
 		struct task_struct *t;
 
 		t = kthread_create(irq_thread, new, "irq/%d-%s", irq,
@@ -943,6 +942,13 @@ __setup_irq(unsigned int irq, struct irq_desc *desc, struct irqaction *new)
 			ret = PTR_ERR(t);
 			goto out_mput;
 		}
+
+		/*
+		 * Set the priority here rather than in the thread itself,
+		 * so that irq_set_thread_priority() right after the
+		 * request is not overridden when the thread first runs.
+		 */
+		sched_setscheduler_nocheck(t, SCHED_FIFO, &param);
 		/*
 		 * We keep the reference to the task struct even if
 		 * the thread dies to avoid that the interrupt code
@@ -1417,6 +1423,49 @@ int request_threaded_irq(unsigned int irq, irq_handler_t handler,
 }
 EXPORT_SYMBOL(request_threaded_irq);
 
+/**
+ *	irq_set_thread_priority - set the RT priority of an interrupt thread
+ *	@irq: Interrupt line
+ *	@dev_id: Cookie passed to request_threaded_irq()
+ *	@prio: SCHED_FIFO priority, 1 to MAX_USER_RT_PRIO - 1
+ *
+ *	Interrupt threads are created with priority MAX_USER_RT_PRIO/2.
+ *	Drivers may use this to let the platform rank a device above or
+ *	below that default, e.g. to keep bulk I/O completion from delaying
+ *	real time tasks.
+ */
+int irq_set_thread_priority(unsigned int irq, void *dev_id, int prio)
+{
+	struct sched_param param = { .sched_priority = prio };
+	struct irq_desc *desc = irq_to_desc(irq);
+	struct task_struct *t = NULL;
+	struct irqaction *action;
+	unsigned long flags;
+	int ret;
+
+	if (!desc || prio < 1 || prio >= MAX_USER_RT_PRIO)
+		return -EINVAL;
+
+	raw_spin_lock_irqsave(&desc->lock, flags);
+	for (action = desc->action; action; action = action->next) {
+		if (action->dev_id == dev_id) {
+			t = action->thread;
+			if (t)
+				get_task_struct(t);
+			break;
+		}
+	}
+	raw_spin_unlock_irqrestore(&desc->lock, flags);
+
+	if (!t)
+		return -EINVAL;
+
+	ret = sched_setscheduler_nocheck(t, SCHED_FIFO, &param);
+	put_task_struct(t);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(irq_set_thread_priority);
+
 /**
  *	request_any_context_irq - allocate an interrupt line
  *	@irq: Interrupt line to allocate
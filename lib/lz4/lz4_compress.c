@@ -0,0 +1,160 @@
+/*
+ *  LZ4 Compressor
+ *
+ *  Greedy single pass compressor producing the LZ4 block format, see
+ *  lz4defs.h.  Candidate matches come from a hash table of the last
+ *  position each 4-byte sequence was seen at.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/bitops.h>
+#include <linux/string.h>
+#include <linux/lz4.h>
+#include <asm/unaligned.h>
+#include "lz4defs.h"
+
+static inline u32 lz4_read32(const unsigned char *p)
+{
+	return get_unaligned((const u32 *)p);
+}
+
+static inline u32 lz4_hash(u32 seq)
+{
+	return (seq * 2654435761U) >> (32 - LZ4_HASH_LOG);
+}
+
+/* Number of leading bytes two words have in common, diff is their xor */
+static inline unsigned int lz4_common_bytes(unsigned long diff)
+{
+#ifdef __LITTLE_ENDIAN
+	return __ffs(diff) >> 3;
+#else
+	return (BITS_PER_LONG - 1 - __fls(diff)) >> 3;
+#endif
+}
+
+static inline unsigned char *lz4_put_length(unsigned char *op, size_t len)
+{
+	for (; len >= 255; len -= 255)
+		*op++ = 255;
+	*op++ = len;
+	return op;
+}
+
+static inline unsigned char *lz4_put_literals(unsigned char *op,
+		const unsigned char *anchor, size_t lit, unsigned char **token)
+{
+	*token = op++;
+	if (lit >= LZ4_RUN_MASK) {
+		**token = LZ4_RUN_MASK << LZ4_ML_BITS;
+		op = lz4_put_length(op, lit - LZ4_RUN_MASK);
+	} else {
+		**token = lit << LZ4_ML_BITS;
+	}
+	memcpy(op, anchor, lit);
+	return op + lit;
+}
+
+int lz4_compress(const unsigned char *src, size_t src_len,
+		unsigned char *dst, size_t *dst_len, void *wrkmem)
+{
+	const unsigned char * const iend = src + src_len;
+	const unsigned char * const mflimit = iend - LZ4_MFLIMIT;
+	const unsigned char * const matchlimit = iend - LZ4_LASTLITERALS;
+	const unsigned char *ip = src, *anchor = src;
+	unsigned char *op = dst, *token;
+	u32 *table = wrkmem;
+
+	if (src_len < LZ4_MFLIMIT + 1)
+		goto last_literals;
+
+	/*
+	 * The table is not cleared between calls: entries are offsets into
+	 * src, and a candidate is only used after checking that it lies
+	 * before ip, within LZ4_MAX_DISTANCE and really matches, so stale
+	 * entries merely cost a miss.
+	 */
+	table[lz4_hash(lz4_read32(ip))] = 0;
+	ip++;
+
+	while (ip <= mflimit) {
+		const unsigned char *ref;
+		u32 seq = lz4_read32(ip);
+		u32 h = lz4_hash(seq);
+		u32 pos = ip - src;
+		u32 cand = table[h];
+		size_t len;
+
+		table[h] = pos;
+		/*
+		 * Range check the offsets, not pointers: src + a stale entry
+		 * may wrap around on 32-bit.
+		 */
+		if (cand >= pos || pos - cand > LZ4_MAX_DISTANCE ||
+		    lz4_read32(src + cand) != seq) {
+			/* Skip faster through data that does not compress */
+			ip += 1 + ((ip - anchor) >> LZ4_SKIP_STRENGTH);
+			continue;
+		}
+		ref = src + cand;
+
+		/* Extend the match backwards over pending literals */
+		while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+			ip--;
+			ref--;
+		}
+
+		op = lz4_put_literals(op, anchor, ip - anchor, &token);
+		put_unaligned_le16(ip - ref, op);
+		op += 2;
+
+		/* Extend the match forwards, a word at a time */
+		anchor = ip;
+		ip += LZ4_MINMATCH;
+		ref += LZ4_MINMATCH;
+		while (ip < matchlimit - (sizeof(long) - 1)) {
+			unsigned long diff = get_unaligned((const unsigned long *)ref) ^
+					     get_unaligned((const unsigned long *)ip);
+
+			if (!diff) {
+				ip += sizeof(long);
+				ref += sizeof(long);
+				continue;
+			}
+			ip += lz4_common_bytes(diff);
+			goto match_end;
+		}
+		while (ip < matchlimit && *ip == *ref) {
+			ip++;
+			ref++;
+		}
+match_end:
+		len = ip - anchor - LZ4_MINMATCH;
+		if (len >= LZ4_ML_MASK) {
+			*token |= LZ4_ML_MASK;
+			op = lz4_put_length(op, len - LZ4_ML_MASK);
+		} else {
+			*token |= len;
+		}
+		anchor = ip;
+
+		/* Index a position inside the match for the next search */
+		if (ip <= mflimit)
+			table[lz4_hash(lz4_read32(ip - 2))] = ip - 2 - src;
+	}
+
+last_literals:
+	op = lz4_put_literals(op, anchor, iend - anchor, &token);
+
+	*dst_len = op - dst;
+	return LZ4_E_OK;
+}
+EXPORT_SYMBOL_GPL(lz4_compress);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("LZ4 Compressor");
@@ -0,0 +1,122 @@
+/*
+ *  LZ4 Decompressor
+ *
+ *  Decodes the LZ4 block format, see lz4defs.h.  Every length and
+ *  offset is checked against the input and output buffers, so corrupt
+ *  input can not make it read or write out of bounds.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/lz4.h>
+#include <asm/unaligned.h>
+#include "lz4defs.h"
+
+/* Returns false if the input ends before the length does */
+static inline bool lz4_get_length(const unsigned char **ip,
+		const unsigned char *iend, size_t *len)
+{
+	unsigned int s;
+
+	do {
+		if (unlikely(*ip >= iend))
+			return false;
+		s = *(*ip)++;
+		*len += s;
+	} while (s == 255);
+
+	return true;
+}
+
+int lz4_decompress_safe(const unsigned char *src, size_t src_len,
+		unsigned char *dst, size_t *dst_len)
+{
+	const unsigned char *ip = src;
+	const unsigned char * const iend = src + src_len;
+	unsigned char *op = dst;
+	unsigned char * const oend = dst + *dst_len;
+
+	for (;;) {
+		const unsigned char *ref;
+		unsigned int token;
+		size_t len, offset;
+
+		if (unlikely(ip >= iend))
+			goto input_overrun;
+		token = *ip++;
+
+		/* Literals */
+		len = token >> LZ4_ML_BITS;
+		if (len == LZ4_RUN_MASK && !lz4_get_length(&ip, iend, &len))
+			goto input_overrun;
+		if (unlikely(len > iend - ip))
+			goto input_overrun;
+		if (unlikely(len > oend - op))
+			goto output_overrun;
+		memcpy(op, ip, len);
+		ip += len;
+		op += len;
+
+		/* The last sequence has no match */
+		if (ip == iend)
+			break;
+
+		if (unlikely(iend - ip < 2))
+			goto input_overrun;
+		offset = get_unaligned_le16(ip);
+		ip += 2;
+		if (unlikely(!offset || offset > op - dst))
+			goto lookbehind_overrun;
+		ref = op - offset;
+
+		len = token & LZ4_ML_MASK;
+		if (len == LZ4_ML_MASK && !lz4_get_length(&ip, iend, &len))
+			goto input_overrun;
+		len += LZ4_MINMATCH;
+		if (unlikely(len > oend - op))
+			goto output_overrun;
+
+		/*
+		 * Matches may overlap their own output.  Eight byte chunks are
+		 * safe once the source is at least that far behind, as long
+		 * as the last chunk's overshoot stays inside dst.
+		 */
+		if (offset >= 8 && len + 8 <= oend - op) {
+			unsigned char *cpy = op + len;
+
+			do {
+				memcpy(op, ref, 8);
+				op += 8;
+				ref += 8;
+			} while (op < cpy);
+			op = cpy;
+		} else {
+			while (len--)
+				*op++ = *ref++;
+		}
+	}
+
+	*dst_len = op - dst;
+	return LZ4_E_OK;
+
+input_overrun:
+	*dst_len = op - dst;
+	return LZ4_E_INPUT_OVERRUN;
+
+output_overrun:
+	*dst_len = op - dst;
+	return LZ4_E_OUTPUT_OVERRUN;
+
+lookbehind_overrun:
+	*dst_len = op - dst;
+	return LZ4_E_LOOKBEHIND_OVERRUN;
+}
+EXPORT_SYMBOL_GPL(lz4_decompress_safe);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("LZ4 Decompressor");
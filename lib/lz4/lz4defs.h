@@ -0,0 +1,27 @@
+/*
+ *  lz4defs.h -- LZ4 block format definitions
+ *
+ *  A compressed block is a series of sequences.  Each starts with a
+ *  token byte: the high nibble is the number of literals, the low
+ *  nibble the match length minus LZ4_MINMATCH.  A nibble of 15 is
+ *  continued by bytes added to it until one is below 255.  The literals
+ *  follow, then a little endian 16-bit match offset and the match length
+ *  continuation bytes.  The last sequence has literals only, and the
+ *  last LZ4_LASTLITERALS bytes of a block are always literals.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ */
+
+#define LZ4_MINMATCH		4
+#define LZ4_LASTLITERALS	5
+#define LZ4_MFLIMIT		(8 + LZ4_MINMATCH)
+#define LZ4_MAX_DISTANCE	65535
+
+#define LZ4_ML_BITS		4
+#define LZ4_ML_MASK		((1U << LZ4_ML_BITS) - 1)
+#define LZ4_RUN_MASK		((1U << (8 - LZ4_ML_BITS)) - 1)
+
+/* Step up the search stride by one every 2^SKIP_STRENGTH misses */
+#define LZ4_SKIP_STRENGTH	6
@@ -11,12 +11,63 @@
  *  Richard Purdie <rpurdie@openedhand.com>
  */
 
+#ifndef STATIC
 #include <linux/module.h>
 #include <linux/kernel.h>
+#endif
+
+#include <linux/bitops.h>
 #include <linux/lzo.h>
 #include <asm/unaligned.h>
 #include "lzodefs.h"
 
+static inline unsigned char *lzo_copy_literals(unsigned char *op,
+		const unsigned char *ii, size_t t)
+{
+#ifdef LZO_UNALIGNED_OK
+	for (; t >= 4; t -= 4) {
+		COPY4(op, ii);
+		op += 4;
+		ii += 4;
+	}
+	if (!t)
+		return op;
+#endif
+	do {
+		*op++ = *ii++;
+	} while (--t > 0);
+	return op;
+}
+
+/*
+ * Advance ip while it matches m, stopping at end.  The word-wise variant
+ * finds the first differing byte from the xor of two words.
+ */
+static inline const unsigned char *lzo_match_end(const unsigned char *ip,
+		const unsigned char *m, const unsigned char *end)
+{
+#ifdef LZO_UNALIGNED_OK
+	while (end - ip >= sizeof(long)) {
+		unsigned long diff = LOAD_WORD(m) ^ LOAD_WORD(ip);
+
+		if (diff) {
+#ifdef __LITTLE_ENDIAN
+			return ip + (__ffs(diff) >> 3);
+#else
+			return ip + ((BITS_PER_LONG - 1 - __fls(diff)) >> 3);
+#endif
+		}
+		ip += sizeof(long);
+		m += sizeof(long);
+	}
+#endif
+	while (ip < end && *m == *ip) {
+		m++;
+		ip++;
+	}
+	return ip;
+}
+
 static noinline size_t
 _lzo1x_1_do_compress(const unsigned char *in, size_t in_len,
 		unsigned char *out, size_t *out_len, void *wrkmem)
@@ -61,8 +112,7 @@ _lzo1x_1_do_compress(const unsigned char *in, size_t in_len,
 		goto literal;
 
 try_match:
-		if (get_unaligned((const unsigned short *)m_pos)
-				== get_unaligned((const unsigned short *)ip)) {
+		if (GET16(m_pos) == GET16(ip)) {
 			if (likely(m_pos[2] == ip[2]))
 					goto match;
 		}
@@ -93,9 +143,8 @@ match:
 				}
 				*op++ = tt;
 			}
-			do {
-				*op++ = *ii++;
-			} while (--t > 0);
+			op = lzo_copy_literals(op, ii, t);
+			ii += t;
 		}
 
 		ip += 3;
@@ -125,10 +174,7 @@ match:
 			end = in_end;
 			m = m_pos + M2_MAX_LEN + 1;
 
-			while (ip < end && *m == *ip) {
-				m++;
-				ip++;
-			}
+			ip = lzo_match_end(ip, m, end);
 			m_len = ip - ii;
 
 			if (m_off <= M3_MAX_OFFSET) {
@@ -207,9 +253,7 @@ int lzo1x_1_compress(const unsigned char *in, size_t in_len, unsigned char *out,
 
 			*op++ = tt;
 		}
-		do {
-			*op++ = *ii++;
-		} while (--t > 0);
+		op = lzo_copy_literals(op, ii, t);
 	}
 
 	*op++ = M4_MARKER | 1;
@@ -219,8 +263,11 @@ int lzo1x_1_compress(const unsigned char *in, size_t in_len, unsigned char *out,
 	*out_len = op - out;
 	return LZO_E_OK;
 }
+#ifndef STATIC
 EXPORT_SYMBOL_GPL(lzo1x_1_compress);
 
 MODULE_LICENSE("GPL");
 MODULE_DESCRIPTION("LZO1X-1 Compressor");
 
+#endif
+
@@ -24,9 +24,6 @@
 #define HAVE_OP(x, op_end, op) ((size_t)(op_end - op) < (x))
 #define HAVE_LB(m_pos, out, op) (m_pos < out || m_pos >= op)
 
-#define COPY4(dst, src)	\
-		put_unaligned(get_unaligned((const u32 *)(src)), (u32 *)(dst))
-
 int lzo1x_decompress_safe(const unsigned char *in, size_t in_len,
 			unsigned char *out, size_t *out_len)
 {
@@ -72,6 +69,25 @@ int lzo1x_decompress_safe(const unsigned char *in, size_t in_len,
 		if (HAVE_IP(t + 4, ip_end, ip))
 			goto input_overrun;
 
+#ifdef LZO_UNALIGNED_OK
+		/*
+		 * With 7 bytes of slack in both buffers, copy the whole run
+		 * in words and let the last one spill over.
+		 */
+		if (!HAVE_OP(t + 3 + 7, op_end, op) &&
+		    !HAVE_IP(t + 3 + 7, ip_end, ip)) {
+			unsigned char *oe = op + t + 3;
+
+			do {
+				COPY8(op, ip);
+				op += 8;
+				ip += 8;
+			} while (op < oe);
+			ip -= op - oe;
+			op = oe;
+			goto first_literal_run;
+		}
+#endif
 		COPY4(op, ip);
 		op += 4;
 		ip += 4;
@@ -125,6 +141,13 @@ match:
 					goto lookbehind_overrun;
 				if (HAVE_OP(t + 3 - 1, op_end, op))
 					goto output_overrun;
+#ifdef LZO_UNALIGNED_OK
+				if (op - m_pos >= 8 && !HAVE_OP(8, op_end, op)) {
+					COPY8(op, m_pos);
+					op += t + 2;
+					goto match_done;
+				}
+#endif
 				goto copy_match;
 			} else if (t >= 32) {
 				t &= 31;
@@ -183,6 +206,23 @@ match:
 			if (HAVE_OP(t + 3 - 1, op_end, op))
 				goto output_overrun;
 
+#ifdef LZO_UNALIGNED_OK
+			/*
+			 * A source at least 8 bytes back cannot overlap the word
+			 * being written.
+			 */
+			if (op - m_pos >= 8 && !HAVE_OP(t + 2 + 7, op_end, op)) {
+				unsigned char *oe = op + t + 2;
+
+				do {
+					COPY8(op, m_pos);
+					op += 8;
+					m_pos += 8;
+				} while (op < oe);
+				op = oe;
+				goto match_done;
+			}
+#endif
 			if (t >= 2 * 4 - (3 - 1) && (op - m_pos) >= 4) {
 				COPY4(op, m_pos);
 				op += 4;
@@ -216,6 +256,15 @@ match_next:
 			if (HAVE_IP(t + 1, ip_end, ip))
 				goto input_overrun;
 
+#ifdef LZO_UNALIGNED_OK
+			if (!HAVE_OP(4, op_end, op) && !HAVE_IP(4, ip_end, ip)) {
+				COPY4(op, ip);
+				op += t;
+				ip += t;
+				t = *ip++;
+				continue;
+			}
+#endif
 			*op++ = *ip++;
 			if (t > 1) {
 				*op++ = *ip++;
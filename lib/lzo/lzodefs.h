@@ -11,6 +11,9 @@
  *  Richard Purdie <rpurdie@openedhand.com>
  */
 
+#ifndef _LZODEFS_H
+#define _LZODEFS_H
+
 #define LZO_VERSION		0x2020
 #define LZO_VERSION_STRING	"2.02"
 #define LZO_VERSION_DATE	"Oct 17 2005"
@@ -41,3 +44,38 @@
 #define DX2(p, s1, s2)	(((((size_t)((p)[2]) << (s2)) ^ (p)[1]) \
 							<< (s1)) ^ (p)[0])
 #define DX3(p, s1, s2, s3)	((DX2((p)+1, s2, s3) << (s1)) ^ (p)[0])
+
+/*
+ * Copy literal and match runs a word at a time where the CPU loads and
+ * stores unaligned words in hardware.  ARMv6 and later do, but the ARM
+ * get_unaligned() is byte-wise, so go through packed structs instead.
+ * The preboot decompressor (STATIC) may run with the MMU off, where
+ * unaligned accesses fault, and keeps the portable byte copies.
+ */
+#if !defined(STATIC) && (defined(CONFIG_HAVE_EFFICIENT_UNALIGNED_ACCESS) || \
+	(defined(__arm__) && __LINUX_ARM_ARCH__ >= 6))
+#define LZO_UNALIGNED_OK	1
+#endif
+
+#ifdef LZO_UNALIGNED_OK
+#include <linux/unaligned/packed_struct.h>
+
+#define GET16(p)	__get_unaligned_cpu16(p)
+#define COPY4(dst, src)	\
+		__put_unaligned_cpu32(__get_unaligned_cpu32(src), (dst))
+#if BITS_PER_LONG == 64
+#define COPY8(dst, src)	\
+		__put_unaligned_cpu64(__get_unaligned_cpu64(src), (dst))
+#define LOAD_WORD(p)	((unsigned long)__get_unaligned_cpu64(p))
+#else
+#define COPY8(dst, src)	\
+		do { COPY4(dst, src); COPY4((dst) + 4, (src) + 4); } while (0)
+#define LOAD_WORD(p)	((unsigned long)__get_unaligned_cpu32(p))
+#endif
+#else
+#define GET16(p)	get_unaligned((const unsigned short *)(p))
+#define COPY4(dst, src)	\
+		put_unaligned(get_unaligned((const u32 *)(src)), (u32 *)(dst))
+#endif
+
+#endif
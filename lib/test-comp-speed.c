@@ -0,0 +1,192 @@
+/*
+ * Page compression benchmark
+ *
+ * Snapshots a sample of pages currently on the LRU lists, i.e. the
+ * anonymous and page cache data zram or zcache would see, then
+ * compresses and decompresses every page with each requested crypto
+ * API compressor.  Throughput in MB/s and the compressed size as a
+ * percentage of the input are printed to the kernel log when the
+ * module is loaded.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/crypto.h>
+#include <linux/err.h>
+#include <linux/highmem.h>
+#include <linux/ktime.h>
+#include <linux/mm.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+
+static char *algs = "lzo,lz4,deflate";
+module_param(algs, charp, 0444);
+MODULE_PARM_DESC(algs, "Comma separated list of compressors to test");
+
+static unsigned int nr_pages = 1024;
+module_param(nr_pages, uint, 0444);
+MODULE_PARM_DESC(nr_pages, "Number of sample pages");
+
+static bool page_is_zero(const void *addr)
+{
+	const unsigned long *p = addr;
+	unsigned int i;
+
+	for (i = 0; i < PAGE_SIZE / sizeof(*p); i++)
+		if (p[i])
+			return false;
+	return true;
+}
+
+/*
+ * Copy up to nr_pages LRU pages, spread over all of memory, into
+ * samples.  All-zero pages are skipped: zram stores them without
+ * compressing.  Returns the number of pages copied.
+ */
+static unsigned int collect_samples(char *samples, unsigned int *zero)
+{
+	unsigned long stride, i;
+	unsigned int n = 0;
+
+	stride = max(1UL, max_mapnr / (nr_pages * 4UL));
+
+	for (i = 0; i < max_mapnr && n < nr_pages; i += stride) {
+		struct page *page = mem_map + i;
+		void *addr;
+
+		if (!pfn_valid(page_to_pfn(page)))
+			continue;
+		if (!PageLRU(page) || PageReserved(page))
+			continue;
+
+		addr = kmap_atomic(page);
+		memcpy(samples + n * PAGE_SIZE, addr, PAGE_SIZE);
+		kunmap_atomic(addr);
+
+		if (page_is_zero(samples + n * PAGE_SIZE))
+			(*zero)++;
+		else
+			n++;
+
+		if (!(i % (stride * 64)))
+			cond_resched();
+	}
+
+	return n;
+}
+
+static u64 mb_per_sec(u64 bytes, u64 ns)
+{
+	return ns ? div64_u64(bytes * 1000, ns) : 0;
+}
+
+static void test_alg(const char *name, const char *samples, unsigned int n,
+		     u8 *cbuf, u8 *dbuf)
+{
+	u64 comp_ns = 0, decomp_ns = 0, out_bytes = 0;
+	unsigned int i, errors = 0, incompressible = 0;
+	struct crypto_comp *tfm;
+
+	tfm = crypto_alloc_comp(name, 0, 0);
+	if (IS_ERR(tfm)) {
+		pr_info("comp speed: %s: not available (%ld)\n", name,
+			PTR_ERR(tfm));
+		return;
+	}
+
+	for (i = 0; i < n; i++) {
+		const u8 *src = samples + i * PAGE_SIZE;
+		unsigned int clen = 2 * PAGE_SIZE, dlen = PAGE_SIZE;
+		ktime_t t0, t1, t2;
+		int ret;
+
+		t0 = ktime_get();
+		ret = crypto_comp_compress(tfm, src, PAGE_SIZE, cbuf, &clen);
+		t1 = ktime_get();
+		if (ret) {
+			errors++;
+			continue;
+		}
+		ret = crypto_comp_decompress(tfm, cbuf, clen, dbuf, &dlen);
+		t2 = ktime_get();
+		if (ret || dlen != PAGE_SIZE || memcmp(src, dbuf, PAGE_SIZE)) {
+			errors++;
+			continue;
+		}
+
+		comp_ns += ktime_to_ns(ktime_sub(t1, t0));
+		decomp_ns += ktime_to_ns(ktime_sub(t2, t1));
+		out_bytes += clen;
+		if (clen >= PAGE_SIZE)
+			incompressible++;
+
+		if (!(i % 64))
+			cond_resched();
+	}
+	crypto_free_comp(tfm);
+
+	n -= errors;
+	if (!n) {
+		pr_info("comp speed: %s: all %u pages failed\n", name, errors);
+		return;
+	}
+
+	pr_info("comp speed: %-8s compress %4llu MB/s, decompress %4llu MB/s, "
+		"ratio %3llu%%, %u incompressible, %u errors\n", name,
+		mb_per_sec((u64)n * PAGE_SIZE, comp_ns),
+		mb_per_sec((u64)n * PAGE_SIZE, decomp_ns),
+		div64_u64(out_bytes * 100, (u64)n * PAGE_SIZE),
+		incompressible, errors);
+}
+
+static int __init test_comp_speed_init(void)
+{
+	unsigned int n, zero = 0;
+	char *samples, *list, *p, *name;
+	u8 *cbuf, *dbuf;
+	int ret = -ENOMEM;
+
+	if (!nr_pages)
+		return -EINVAL;
+
+	samples = vmalloc(nr_pages * PAGE_SIZE);
+	cbuf = kmalloc(2 * PAGE_SIZE, GFP_KERNEL);
+	dbuf = kmalloc(PAGE_SIZE, GFP_KERNEL);
+	list = kstrdup(algs, GFP_KERNEL);
+	if (!samples || !cbuf || !dbuf || !list)
+		goto out;
+
+	n = collect_samples(samples, &zero);
+	pr_info("comp speed: %u sample pages, %u zero pages skipped\n",
+		n, zero);
+	ret = 0;
+	if (!n)
+		goto out;
+
+	p = list;
+	while ((name = strsep(&p, ",")) != NULL)
+		if (*name)
+			test_alg(name, samples, n, cbuf, dbuf);
+
+out:
+	kfree(list);
+	kfree(dbuf);
+	kfree(cbuf);
+	vfree(samples);
+	return ret;
+}
+
+static void __exit test_comp_speed_exit(void)
+{
+}
+
+module_init(test_comp_speed_init);
+module_exit(test_comp_speed_exit);
+MODULE_DESCRIPTION("Page compression benchmark");
+MODULE_LICENSE("GPL v2");
@@ -0,0 +1,156 @@
+/*
+ * hrtimer wake-up latency benchmark
+ *
+ * Arms a periodic absolute hrtimer and measures how late its expiry is
+ * seen, first from the hrtimer callback (interrupt latency) and then
+ * from a SCHED_FIFO kernel thread sleeping in schedule_hrtimeout()
+ * (wake-up latency).  Results are printed to the kernel log when the
+ * module is loaded.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/kthread.h>
+#include <linux/completion.h>
+#include <linux/sched.h>
+
+static unsigned int period_us = 1000;
+module_param(period_us, uint, 0444);
+MODULE_PARM_DESC(period_us, "Timer period in microseconds");
+
+static unsigned int loops = 10000;
+module_param(loops, uint, 0444);
+MODULE_PARM_DESC(loops, "Number of timer expiries per test");
+
+static const unsigned int bucket_us[] = { 1, 2, 5, 10, 20, 50, 100 };
+
+struct latency_stats {
+	s64		min;
+	s64		max;
+	s64		sum;
+	unsigned int	count;
+	unsigned int	hist[ARRAY_SIZE(bucket_us) + 1];
+};
+
+static void latency_add(struct latency_stats *st, s64 ns)
+{
+	unsigned int i;
+
+	if (!st->count || ns < st->min)
+		st->min = ns;
+	if (!st->count || ns > st->max)
+		st->max = ns;
+	st->sum += ns;
+	st->count++;
+
+	for (i = 0; i < ARRAY_SIZE(bucket_us); i++)
+		if (ns < bucket_us[i] * NSEC_PER_USEC)
+			break;
+	st->hist[i]++;
+}
+
+static void latency_report(const char *name, struct latency_stats *st)
+{
+	unsigned int i;
+
+	if (!st->count)
+		return;
+
+	pr_info("hrtimer latency: %s: %u samples, min %lld ns, avg %lld ns, "
+		"max %lld ns\n", name, st->count, st->min,
+		div_s64(st->sum, st->count), st->max);
+
+	for (i = 0; i < ARRAY_SIZE(bucket_us); i++)
+		pr_info("hrtimer latency: %s:   < %3u us: %u\n", name,
+			bucket_us[i], st->hist[i]);
+	pr_info("hrtimer latency: %s:  >= %3u us: %u\n", name,
+		bucket_us[i - 1], st->hist[i]);
+}
+
+static struct latency_stats irq_stats;
+static struct latency_stats thread_stats;
+static struct hrtimer test_timer;
+static DECLARE_COMPLETION(test_done);
+
+static enum hrtimer_restart test_timer_fn(struct hrtimer *timer)
+{
+	ktime_t now = hrtimer_cb_get_time(timer);
+
+	latency_add(&irq_stats,
+		ktime_to_ns(ktime_sub(now, hrtimer_get_expires(timer))));
+
+	if (irq_stats.count >= loops) {
+		complete(&test_done);
+		return HRTIMER_NORESTART;
+	}
+
+	hrtimer_forward(timer, now, ns_to_ktime(period_us * NSEC_PER_USEC));
+	return HRTIMER_RESTART;
+}
+
+static int test_thread_fn(void *unused)
+{
+	struct sched_param param = { .sched_priority = MAX_RT_PRIO - 1 };
+	ktime_t next, now;
+	unsigned int i;
+
+	sched_setscheduler(current, SCHED_FIFO, &param);
+
+	next = ktime_get();
+	for (i = 0; i < loops; i++) {
+		next = ktime_add_us(next, period_us);
+
+		set_current_state(TASK_UNINTERRUPTIBLE);
+		schedule_hrtimeout(&next, HRTIMER_MODE_ABS);
+
+		now = ktime_get();
+		latency_add(&thread_stats, ktime_to_ns(ktime_sub(now, next)));
+	}
+
+	complete_and_exit(&test_done, 0);
+}
+
+static int __init test_hrtimer_latency_init(void)
+{
+	struct task_struct *tsk;
+	struct timespec res;
+
+	if (!period_us || !loops)
+		return -EINVAL;
+
+	hrtimer_get_res(CLOCK_MONOTONIC, &res);
+	pr_info("hrtimer latency: clock resolution %ld ns, period %u us, "
+		"%u loops\n", res.tv_nsec, period_us, loops);
+
+	hrtimer_init(&test_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+	test_timer.function = test_timer_fn;
+	hrtimer_start(&test_timer,
+		ktime_add_us(ktime_get(), period_us), HRTIMER_MODE_ABS);
+	wait_for_completion(&test_done);
+	hrtimer_cancel(&test_timer);
+	latency_report("irq", &irq_stats);
+
+	INIT_COMPLETION(test_done);
+	tsk = kthread_run(test_thread_fn, NULL, "hrtimer_latency");
+	if (IS_ERR(tsk))
+		return PTR_ERR(tsk);
+	wait_for_completion(&test_done);
+	latency_report("thread", &thread_stats);
+
+	return 0;
+}
+
+static void __exit test_hrtimer_latency_exit(void)
+{
+}
+
+module_init(test_hrtimer_latency_init);
+module_exit(test_hrtimer_latency_exit);
+MODULE_DESCRIPTION("hrtimer wake-up latency benchmark");
+MODULE_LICENSE("GPL v2");
@@ -0,0 +1,292 @@
+/*
+ * LZO self-test and benchmark
+ *
+ * lib/lzo copies literal and match runs a word at a time on CPUs with
+ * fast unaligned access.  This module builds a second, portable copy of
+ * the same sources, with STATIC defined as for the preboot decompressor,
+ * and checks that both produce identical compressed streams and behave
+ * identically on valid, truncated and corrupted input.  It then reports
+ * the throughput of both on each kind of test data, in page sized
+ * blocks as zram and UBIFS use them.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/ktime.h>
+#include <linux/lzo.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+
+#define STATIC static
+#define lzo1x_1_compress	lzo1x_1_compress_ref
+#define lzo1x_decompress_safe	lzo1x_decompress_safe_ref
+#include "lzo/lzo1x_compress.c"
+#include "lzo/lzo1x_decompress.c"
+#undef lzo1x_decompress_safe
+#undef lzo1x_1_compress
+#undef STATIC
+
+static unsigned int iterations = 8;
+module_param(iterations, uint, 0444);
+MODULE_PARM_DESC(iterations, "Benchmark passes over each data set");
+
+#define DATA_LEN	(256 * 1024)
+#define MAX_BLOCK	(4 * PAGE_SIZE)
+#define SLACK		64
+
+struct lzo_impl {
+	const char *name;
+	int (*compress)(const unsigned char *src, size_t src_len,
+			unsigned char *dst, size_t *dst_len, void *wrkmem);
+	int (*decompress)(const unsigned char *src, size_t src_len,
+			  unsigned char *dst, size_t *dst_len);
+};
+
+static const struct lzo_impl impls[] = {
+	{ "kernel", lzo1x_1_compress, lzo1x_decompress_safe },
+	{ "portable", lzo1x_1_compress_ref, lzo1x_decompress_safe_ref },
+};
+
+enum { DATA_SPARSE, DATA_TEXT, DATA_PERIODIC, DATA_RANDOM, NR_DATA };
+
+static const char * const data_names[NR_DATA] = {
+	"sparse", "text", "periodic", "random",
+};
+
+static u8 *cbuf, *rbuf, *dbuf, *rdbuf;
+static void *wrkmem;
+static u32 test_seed = 2463534242U;
+
+static u32 test_rand(void)
+{
+	test_seed ^= test_seed << 13;
+	test_seed ^= test_seed >> 17;
+	test_seed ^= test_seed << 5;
+	return test_seed;
+}
+
+static void fill_data(u8 *data, int kind)
+{
+	static const char * const words[] = {
+		"the ", "page ", "cache ", "of ", "swap ", "struct ", "0x0000",
+		"return ", "\n\t", "int ", "if (", ") {\n", "zram", "=", ";\n",
+	};
+	size_t i = 0, n, dist;
+	const char *w;
+
+	while (i < DATA_LEN) {
+		switch (kind) {
+		case DATA_SPARSE:
+			data[i++] = test_rand() % 64 ? 0 : test_rand();
+			break;
+		case DATA_TEXT:
+			w = words[test_rand() % ARRAY_SIZE(words)];
+			n = min_t(size_t, strlen(w), DATA_LEN - i);
+			memcpy(data + i, w, n);
+			i += n;
+			break;
+		case DATA_PERIODIC:
+			/* Short distances exercise the overlapping copies */
+			data[i++] = test_rand();
+			dist = test_rand() % 16 + 1;
+			if (dist > i)
+				break;
+			for (n = min_t(size_t, test_rand() % 256, DATA_LEN - i);
+			     n; n--, i++)
+				data[i] = data[i - dist];
+			break;
+		default:
+			data[i++] = test_rand();
+			break;
+		}
+	}
+}
+
+/*
+ * Decompress with both implementations, which must agree on the result,
+ * the output length and the bytes written.
+ */
+static int compare_decompress(const u8 *in, size_t in_len, size_t out_len,
+			      int *ret)
+{
+	size_t dlen = out_len, rdlen = out_len;
+	int rret;
+
+	*ret = lzo1x_decompress_safe(in, in_len, dbuf, &dlen);
+	rret = lzo1x_decompress_safe_ref(in, in_len, rdbuf, &rdlen);
+	if (*ret != rret || dlen != rdlen || memcmp(dbuf, rdbuf, dlen)) {
+		pr_err("lzo test: decompressing %zu bytes into %zu: "
+		       "returned %d/%d, %zu/%zu bytes\n", in_len, out_len,
+		       *ret, rret, dlen, rdlen);
+		return -EINVAL;
+	}
+	return 0;
+}
+
+static int check_block(const u8 *src, size_t len)
+{
+	size_t clen, rlen, i;
+	int ret;
+
+	/* Stale dictionary entries would steer the two apart */
+	memset(wrkmem, 0, LZO1X_1_MEM_COMPRESS);
+	lzo1x_1_compress(src, len, cbuf, &clen, wrkmem);
+	memset(wrkmem, 0, LZO1X_1_MEM_COMPRESS);
+	lzo1x_1_compress_ref(src, len, rbuf, &rlen, wrkmem);
+	if (clen != rlen || memcmp(cbuf, rbuf, clen)) {
+		pr_err("lzo test: compressed streams of %zu bytes differ\n",
+		       len);
+		return -EINVAL;
+	}
+
+	/* Exact and roomy output buffers */
+	if (compare_decompress(cbuf, clen, len, &ret))
+		return -EINVAL;
+	if (ret != LZO_E_OK || memcmp(src, dbuf, len))
+		goto bad_round_trip;
+	if (compare_decompress(cbuf, clen, len + SLACK, &ret))
+		return -EINVAL;
+	if (ret != LZO_E_OK || memcmp(src, dbuf, len))
+		goto bad_round_trip;
+
+	/* Short output and truncated input must fail the same way */
+	if (len && compare_decompress(cbuf, clen, len - 1, &ret))
+		return -EINVAL;
+	if (compare_decompress(cbuf, clen - 1, len + SLACK, &ret) ||
+	    compare_decompress(cbuf, clen / 2, len + SLACK, &ret))
+		return -EINVAL;
+
+	/* Corrupted streams */
+	memcpy(rbuf, cbuf, clen);
+	for (i = 0; i < 4; i++) {
+		rbuf[test_rand() % clen] ^= 1 << (test_rand() % 8);
+		if (compare_decompress(rbuf, clen, len + SLACK, &ret))
+			return -EINVAL;
+	}
+	return 0;
+
+bad_round_trip:
+	pr_err("lzo test: %zu bytes did not round trip (%d)\n", len, ret);
+	return -EINVAL;
+}
+
+static int __init test_data(const u8 *data, unsigned int *blocks)
+{
+	size_t len;
+	int i;
+
+	for (len = 0; len <= 64; len++)
+		if (check_block(data, len))
+			return -EINVAL;
+	*blocks += 65;
+
+	for (i = 0; i < 256; i++) {
+		size_t off = test_rand() % (DATA_LEN - MAX_BLOCK);
+
+		len = test_rand() % MAX_BLOCK + 1;
+		if (check_block(data + off, len))
+			return -EINVAL;
+		cond_resched();
+	}
+	*blocks += 256;
+
+	if (check_block(data, MAX_BLOCK))
+		return -EINVAL;
+	(*blocks)++;
+	return 0;
+}
+
+static u64 mb_per_sec(u64 bytes, u64 ns)
+{
+	return ns ? div64_u64(bytes * 1000, ns) : 0;
+}
+
+static void __init bench_data(const u8 *data, int kind,
+			      const struct lzo_impl *impl)
+{
+	u64 comp_ns = 0, decomp_ns = 0, in_bytes = 0, out_bytes = 0;
+	unsigned int pass;
+	size_t off;
+
+	for (pass = 0; pass < iterations; pass++) {
+		for (off = 0; off < DATA_LEN; off += PAGE_SIZE) {
+			size_t clen, dlen = PAGE_SIZE;
+			ktime_t t0, t1, t2;
+
+			t0 = ktime_get();
+			impl->compress(data + off, PAGE_SIZE, cbuf, &clen,
+				       wrkmem);
+			t1 = ktime_get();
+			impl->decompress(cbuf, clen, dbuf, &dlen);
+			t2 = ktime_get();
+
+			comp_ns += ktime_to_ns(ktime_sub(t1, t0));
+			decomp_ns += ktime_to_ns(ktime_sub(t2, t1));
+			in_bytes += PAGE_SIZE;
+			out_bytes += clen;
+		}
+		cond_resched();
+	}
+
+	pr_info("lzo test: %-8s %-8s compress %4llu MB/s, "
+		"decompress %4llu MB/s, ratio %3llu%%\n",
+		data_names[kind], impl->name,
+		mb_per_sec(in_bytes, comp_ns), mb_per_sec(in_bytes, decomp_ns),
+		div64_u64(out_bytes * 100, in_bytes));
+}
+
+static int __init test_lzo_init(void)
+{
+	unsigned int blocks = 0;
+	u8 *data;
+	int kind, i, ret = -ENOMEM;
+
+	data = vmalloc(DATA_LEN);
+	cbuf = kmalloc(lzo1x_worst_compress(MAX_BLOCK), GFP_KERNEL);
+	rbuf = kmalloc(lzo1x_worst_compress(MAX_BLOCK), GFP_KERNEL);
+	dbuf = kmalloc(MAX_BLOCK + SLACK, GFP_KERNEL);
+	rdbuf = kmalloc(MAX_BLOCK + SLACK, GFP_KERNEL);
+	wrkmem = kmalloc(LZO1X_1_MEM_COMPRESS, GFP_KERNEL);
+	if (!data || !cbuf || !rbuf || !dbuf || !rdbuf || !wrkmem)
+		goto out;
+
+	for (kind = 0; kind < NR_DATA; kind++) {
+		fill_data(data, kind);
+		ret = test_data(data, &blocks);
+		if (ret) {
+			pr_err("lzo test: %s data failed\n", data_names[kind]);
+			goto out;
+		}
+	}
+	pr_info("lzo test: %u blocks passed\n", blocks);
+
+	for (kind = 0; kind < NR_DATA; kind++) {
+		fill_data(data, kind);
+		for (i = 0; i < ARRAY_SIZE(impls); i++)
+			bench_data(data, kind, &impls[i]);
+	}
+
+out:
+	kfree(wrkmem);
+	kfree(rdbuf);
+	kfree(dbuf);
+	kfree(rbuf);
+	kfree(cbuf);
+	vfree(data);
+	return ret;
+}
+
+static void __exit test_lzo_exit(void)
+{
+}
+
+module_init(test_lzo_init);
+module_exit(test_lzo_exit);
+MODULE_DESCRIPTION("LZO self-test and benchmark");
+MODULE_LICENSE("GPL v2");
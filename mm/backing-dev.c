@@ -100,6 +100,13 @@ static int bdi_debug_stats_show(struct seq_file *m, void *v)
 		   "BdiDirtied:         %10lu kB\n"
 		   "BdiWritten:         %10lu kB\n"
 		   "BdiWriteBandwidth:  %10lu kBps\n"
+		   "BdiReadahead:       %10lu kB\n"
+		   "BdiReadaheadWindow: %10lu kB\n"
+		   "BdiReadaheadHit:    %10lu\n"
+		   "BdiReadaheadMiss:   %10lu\n"
+		   "BdiReadaheadWait:   %10lu\n"
+		   "BdiReadaheadWaitUs: %10lu\n"
+		   "BdiReadaheadThrash: %10lu kB\n"
 		   "b_dirty:            %10lu\n"
 		   "b_io:               %10lu\n"
 		   "b_more_io:          %10lu\n"
@@ -113,6 +120,13 @@ static int bdi_debug_stats_show(struct seq_file *m, void *v)
 		   (unsigned long) K(bdi_stat(bdi, BDI_DIRTIED)),
 		   (unsigned long) K(bdi_stat(bdi, BDI_WRITTEN)),
 		   (unsigned long) K(bdi->write_bandwidth),
+		   (unsigned long) K(bdi_stat(bdi, BDI_RA_PAGES)),
+		   K(bdi->ra_adaptive ? bdi->ra_window : bdi->ra_pages),
+		   (unsigned long) bdi_stat(bdi, BDI_RA_HIT),
+		   (unsigned long) bdi_stat(bdi, BDI_RA_MISS),
+		   (unsigned long) bdi_stat(bdi, BDI_RA_WAIT),
+		   (unsigned long) bdi_stat(bdi, BDI_RA_WAIT_US),
+		   (unsigned long) K(bdi_stat(bdi, BDI_RA_THRASH)),
 		   nr_dirty,
 		   nr_io,
 		   nr_more_io,
@@ -189,6 +203,50 @@ static ssize_t name##_show(struct device *dev,				\
 
 BDI_SHOW(read_ahead_kb, K(bdi->ra_pages))
 
+static ssize_t read_ahead_adaptive_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+	char *end;
+	unsigned long adaptive;
+	ssize_t ret = -EINVAL;
+
+	adaptive = simple_strtoul(buf, &end, 10);
+	if (*buf && (end[0] == '\0' || (end[0] == '\n' && end[1] == '\0'))) {
+		bdi_set_readahead_adaptive(bdi, !!adaptive);
+		ret = count;
+	}
+	return ret;
+}
+BDI_SHOW(read_ahead_adaptive, bdi->ra_adaptive)
+
+static ssize_t read_ahead_max_kb_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+	char *end;
+	unsigned long max_kb;
+	ssize_t ret = -EINVAL;
+
+	max_kb = simple_strtoul(buf, &end, 10);
+	if (*buf && (end[0] == '\0' || (end[0] == '\n' && end[1] == '\0'))) {
+		if (max_kb < VM_MIN_READAHEAD)
+			return -EINVAL;
+		spin_lock(&bdi->ra_lock);
+		bdi->ra_max_pages = max_kb >> (PAGE_SHIFT - 10);
+		if (bdi->ra_window > bdi->ra_max_pages)
+			bdi->ra_window = bdi->ra_max_pages;
+		spin_unlock(&bdi->ra_lock);
+		ret = count;
+	}
+	return ret;
+}
+BDI_SHOW(read_ahead_max_kb, K(bdi->ra_max_pages))
+
+BDI_SHOW(read_ahead_window_kb,
+	 K(bdi->ra_adaptive ? bdi->ra_window : bdi->ra_pages))
+BDI_SHOW(read_ahead_hit_ratio, bdi_readahead_hit_ratio(bdi))
+
 static ssize_t min_ratio_store(struct device *dev,
 		struct device_attribute *attr, const char *buf, size_t count)
 {
@@ -229,6 +287,10 @@ BDI_SHOW(max_ratio, bdi->max_ratio)
 
 static struct device_attribute bdi_dev_attrs[] = {
 	__ATTR_RW(read_ahead_kb),
+	__ATTR_RW(read_ahead_adaptive),
+	__ATTR_RW(read_ahead_max_kb),
+	__ATTR_RO(read_ahead_window_kb),
+	__ATTR_RO(read_ahead_hit_ratio),
 	__ATTR_RW(min_ratio),
 	__ATTR_RW(max_ratio),
 	__ATTR_NULL,
@@ -673,6 +735,134 @@ static void bdi_wb_init(struct bdi_writeback *wb, struct backing_dev_info *bdi)
  */
 #define INIT_BW		(100 << (20 - PAGE_SHIFT))
 
+/*
+ * Adaptive readahead.
+ *
+ * The readahead window that suits a device depends on its latency and
+ * bandwidth, on its internal geometry (flash page and erase block sizes)
+ * and on how many streams compete for it, so it is measured instead of
+ * guessed.  Every RA_INTERVAL the counters collected by mm/readahead.c
+ * and mm/filemap.c are compared with the previous period:
+ *
+ * - readahead pages reclaimed before they were used mean the window is
+ *   too large for the memory available: halve it;
+ * - readers catching up with the readahead (cache misses of sequential
+ *   streams and waits on pages under readahead I/O) in more than one out
+ *   of four windows mean it is too small: double it; unless the previous
+ *   doubling made the waits 25% longer, which means the device is at its
+ *   limit and larger requests only add latency: halve it back.
+ *
+ * The window stays between VM_MIN_READAHEAD and read_ahead_max_kb.
+ */
+#define RA_INTERVAL	(HZ / 5)
+
+static void __bdi_set_readahead_window(struct backing_dev_info *bdi,
+				       unsigned long window)
+{
+	unsigned long min = VM_MIN_READAHEAD * 1024 / PAGE_CACHE_SIZE;
+
+	bdi->ra_window = clamp(window, min, max(bdi->ra_max_pages, min));
+}
+
+static void __bdi_update_readahead(struct backing_dev_info *bdi,
+				   unsigned long now)
+{
+	s64 cur[NR_BDI_RA_ITEMS];
+	unsigned long pages, hits, stalls, waits, thrash, wait_avg = 0;
+	unsigned long window = bdi->ra_window;
+	int i;
+
+	for (i = 0; i < NR_BDI_RA_ITEMS; i++)
+		cur[i] = percpu_counter_sum(&bdi->bdi_stat[BDI_RA_PAGES + i]);
+
+#define RA_DELTA(item) \
+	((unsigned long)(cur[(item) - BDI_RA_PAGES] - \
+			 bdi->ra_stamp[(item) - BDI_RA_PAGES]))
+	pages = RA_DELTA(BDI_RA_PAGES);
+	hits = RA_DELTA(BDI_RA_HIT);
+	waits = RA_DELTA(BDI_RA_WAIT);
+	stalls = RA_DELTA(BDI_RA_MISS) + waits;
+	thrash = RA_DELTA(BDI_RA_THRASH);
+	if (waits)
+		wait_avg = RA_DELTA(BDI_RA_WAIT_US) / waits;
+#undef RA_DELTA
+
+	bdi->ra_time_stamp = now;
+
+	/* Too little readahead to tell, keep collecting */
+	if (pages < 4 * window)
+		return;
+
+	if (thrash * 8 > pages) {
+		window /= 2;
+		bdi->ra_grown = 0;
+	} else if (stalls * 4 > hits) {
+		if (bdi->ra_grown && wait_avg > bdi->ra_wait_avg * 5 / 4) {
+			window /= 2;
+			bdi->ra_grown = 0;
+		} else {
+			window *= 2;
+			bdi->ra_grown = 1;
+			bdi->ra_wait_avg = wait_avg;
+		}
+	} else
+		bdi->ra_grown = 0;
+
+	__bdi_set_readahead_window(bdi, window);
+	memcpy(bdi->ra_stamp, cur, sizeof(cur));
+}
+
+/*
+ * Called whenever readahead I/O is submitted to @bdi.
+ */
+void bdi_update_readahead(struct backing_dev_info *bdi)
+{
+	unsigned long now = jiffies;
+
+	if (!bdi->ra_adaptive ||
+	    time_before(now, bdi->ra_time_stamp + RA_INTERVAL))
+		return;
+
+	/* Somebody else is doing it */
+	if (!spin_trylock(&bdi->ra_lock))
+		return;
+	if (bdi->ra_adaptive &&
+	    !time_before(now, bdi->ra_time_stamp + RA_INTERVAL))
+		__bdi_update_readahead(bdi, now);
+	spin_unlock(&bdi->ra_lock);
+}
+
+void bdi_set_readahead_adaptive(struct backing_dev_info *bdi, int adaptive)
+{
+	int i;
+
+	spin_lock(&bdi->ra_lock);
+	if (adaptive && !bdi->ra_adaptive) {
+		/* Start from the static setting and fresh counters */
+		for (i = 0; i < NR_BDI_RA_ITEMS; i++)
+			bdi->ra_stamp[i] =
+				percpu_counter_sum(&bdi->bdi_stat[BDI_RA_PAGES + i]);
+		bdi->ra_time_stamp = jiffies;
+		bdi->ra_grown = 0;
+		bdi->ra_wait_avg = 0;
+		__bdi_set_readahead_window(bdi, bdi->ra_pages);
+	}
+	bdi->ra_adaptive = adaptive;
+	spin_unlock(&bdi->ra_lock);
+}
+
+/*
+ * Percentage of readahead windows the readers did not have to wait for.
+ */
+unsigned long bdi_readahead_hit_ratio(struct backing_dev_info *bdi)
+{
+	unsigned long hits = bdi_stat_sum(bdi, BDI_RA_HIT);
+	unsigned long total = hits + bdi_stat_sum(bdi, BDI_RA_MISS) +
+			      bdi_stat_sum(bdi, BDI_RA_WAIT);
+
+	return total ? hits * 100 / total : 0;
+}
+
 int bdi_init(struct backing_dev_info *bdi)
 {
 	int i, err;
@@ -704,6 +894,15 @@ int bdi_init(struct backing_dev_info *bdi)
 	bdi->write_bandwidth = INIT_BW;
 	bdi->avg_write_bandwidth = INIT_BW;
 
+	spin_lock_init(&bdi->ra_lock);
+	bdi->ra_adaptive = 0;
+	bdi->ra_max_pages = VM_MAX_ADAPTIVE_READAHEAD * 1024 / PAGE_CACHE_SIZE;
+	bdi->ra_window = bdi->ra_pages;
+	bdi->ra_time_stamp = jiffies;
+	bdi->ra_grown = 0;
+	bdi->ra_wait_avg = 0;
+	memset(bdi->ra_stamp, 0, sizeof(bdi->ra_stamp));
+
 	err = prop_local_init_percpu(&bdi->completions);
 
 	if (err) {
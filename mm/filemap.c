@@ -142,6 +142,7 @@ void __delete_from_page_cache(struct page *page)
 	 * having removed the page entirely.
 	 */
 	if (PageDirty(page) && mapping_cap_account_dirty(mapping)) {
+		mem_cgroup_dec_page_stat(page, MEMCG_NR_FILE_DIRTY);
 		dec_zone_page_state(page, NR_FILE_DIRTY);
 		dec_bdi_stat(mapping->backing_dev_info, BDI_RECLAIMABLE);
 	}
@@ -1114,9 +1115,12 @@ static void do_generic_file_read(struct file *filp, loff_t *ppos,
 		pgoff_t end_index;
 		loff_t isize;
 		unsigned long nr, ret;
+		u64 ra_wait;
 
 		cond_resched();
 find_page:
+		/* only a wait in lock_page_killable() below is accounted */
+		ra_wait = 0;
 		page = find_get_page(mapping, index);
 		if (!page) {
 			page_cache_sync_readahead(mapping,
@@ -1125,6 +1129,9 @@ find_page:
 			page = find_get_page(mapping, index);
 			if (unlikely(page == NULL))
 				goto no_cached_page;
+		} else if (!PageUptodate(page) && ra->ra_pages) {
+			/* Still being read ahead, we may have to wait */
+			ra_wait = local_clock();
 		}
 		if (PageReadahead(page)) {
 			page_cache_async_readahead(mapping,
@@ -1212,6 +1219,10 @@ page_ok:
 page_not_up_to_date:
 		/* Get exclusive access to the page ... */
 		error = lock_page_killable(page);
+		if (ra_wait) {
+			bdi_readahead_wait(mapping->backing_dev_info, ra_wait);
+			ra_wait = 0;
+		}
 		if (unlikely(error))
 			goto readpage_error;
 
@@ -1600,7 +1611,7 @@ static void do_sync_mmap_readahead(struct vm_area_struct *vma,
 	/*
 	 * mmap read-around
 	 */
-	ra_pages = max_sane_readahead(ra->ra_pages);
+	ra_pages = max_sane_readahead(ra_window_pages(mapping, ra));
 	ra->start = max_t(long, 0, offset - ra_pages / 2);
 	ra->size = ra_pages;
 	ra->async_size = ra_pages / 4;
@@ -1651,6 +1662,7 @@ int filemap_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 	pgoff_t offset = vmf->pgoff;
 	struct page *page;
 	pgoff_t size;
+	u64 ra_wait = 0;
 	int ret = 0;
 
 	size = (i_size_read(inode) + PAGE_CACHE_SIZE - 1) >> PAGE_CACHE_SHIFT;
@@ -1666,6 +1678,8 @@ int filemap_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 		 * We found the page, so try async readahead before
 		 * waiting for the lock.
 		 */
+		if (!PageUptodate(page) && ra->ra_pages)
+			ra_wait = local_clock();
 		do_async_mmap_readahead(vma, ra, file, page, offset);
 	} else {
 		/* No page in the page cache at all */
@@ -1680,9 +1694,15 @@ retry_find:
 	}
 
 	if (!lock_page_or_retry(page, vma->vm_mm, vmf->flags)) {
+		if (ra_wait)
+			bdi_readahead_wait(mapping->backing_dev_info, ra_wait);
 		page_cache_release(page);
 		return ret | VM_FAULT_RETRY;
 	}
+	if (ra_wait) {
+		bdi_readahead_wait(mapping->backing_dev_info, ra_wait);
+		ra_wait = 0;
+	}
 
 	/* Did it get truncated? */
 	if (unlikely(page->mapping != mapping)) {
@@ -49,6 +49,8 @@
 #include <linux/page_cgroup.h>
 #include <linux/cpu.h>
 #include <linux/oom.h>
+#include <linux/vmpressure.h>
+#include <linux/writeback.h>
 #include "internal.h"
 
 #include <asm/uaccess.h>
@@ -85,6 +87,8 @@ enum mem_cgroup_stat_index {
 	MEM_CGROUP_STAT_CACHE, 	   /* # of pages charged as cache */
 	MEM_CGROUP_STAT_RSS,	   /* # of pages charged as anon rss */
 	MEM_CGROUP_STAT_FILE_MAPPED,  /* # of pages charged as file rss */
+	MEM_CGROUP_STAT_FILE_DIRTY,   /* # of dirty pages in page cache */
+	MEM_CGROUP_STAT_FILE_WRITEBACK, /* # of pages under writeback */
 	MEM_CGROUP_STAT_SWAPOUT, /* # of pages, swapped out */
 	MEM_CGROUP_STAT_DATA, /* end of data requires synchronization */
 	MEM_CGROUP_ON_MOVE,	/* someone is moving account between groups */
@@ -253,6 +257,16 @@ struct mem_cgroup {
 	atomic_t	refcnt;
 
 	int	swappiness;
+
+	/*
+	 * Dirty page limits, like vm.dirty_* but relative to the memory
+	 * this cgroup may use.  See mem_cgroup_dirty_limits().
+	 */
+	int		dirty_ratio;
+	int		dirty_background_ratio;
+	unsigned long	dirty_bytes;
+	unsigned long	dirty_background_bytes;
+
 	/* OOM-Killer disable */
 	int		oom_kill_disable;
 
@@ -271,6 +285,9 @@ struct mem_cgroup {
 	/* For oom notifier event fd */
 	struct list_head oom_notify;
 
+	/* Reclaim efficiency, for the memory.pressure_level notifications */
+	struct vmpressure vmpressure;
+
 	/*
 	 * Should we move charges of a task when a task is moved into this
 	 * mem_cgroup ? And what type of charges should we move ?
@@ -1966,6 +1983,33 @@ void mem_cgroup_update_page_stat(struct page *page,
 			ClearPageCgroupFileMapped(pc);
 		idx = MEM_CGROUP_STAT_FILE_MAPPED;
 		break;
+	case MEMCG_NR_FILE_DIRTY:
+		/*
+		 * The flag keeps the counter balanced when a page was
+		 * dirtied before it was charged, or is cleaned after it
+		 * was uncharged.
+		 */
+		if (val > 0) {
+			struct address_space *mapping;
+
+			if (TestSetPageCgroupFileDirty(pc))
+				goto out;
+			/* Let the flusher find this group's inodes */
+			mapping = page_mapping(page);
+			if (mapping)
+				mapping->i_memcg = css_id(&memcg->css);
+		} else if (!TestClearPageCgroupFileDirty(pc))
+			goto out;
+		idx = MEM_CGROUP_STAT_FILE_DIRTY;
+		break;
+	case MEMCG_NR_FILE_WRITEBACK:
+		if (val > 0) {
+			if (TestSetPageCgroupFileWriteback(pc))
+				goto out;
+		} else if (!TestClearPageCgroupFileWriteback(pc))
+			goto out;
+		idx = MEM_CGROUP_STAT_FILE_WRITEBACK;
+		break;
 	default:
 		BUG();
 	}
@@ -2613,6 +2657,19 @@ static int mem_cgroup_move_account(struct page *page,
 		__this_cpu_inc(to->stat->count[MEM_CGROUP_STAT_FILE_MAPPED]);
 		preempt_enable();
 	}
+	if (PageCgroupFileDirty(pc)) {
+		preempt_disable();
+		__this_cpu_dec(from->stat->count[MEM_CGROUP_STAT_FILE_DIRTY]);
+		__this_cpu_inc(to->stat->count[MEM_CGROUP_STAT_FILE_DIRTY]);
+		preempt_enable();
+	}
+	if (PageCgroupFileWriteback(pc)) {
+		preempt_disable();
+		__this_cpu_dec(
+			from->stat->count[MEM_CGROUP_STAT_FILE_WRITEBACK]);
+		__this_cpu_inc(to->stat->count[MEM_CGROUP_STAT_FILE_WRITEBACK]);
+		preempt_enable();
+	}
 	mem_cgroup_charge_statistics(from, PageCgroupCache(pc), -nr_pages);
 	if (uncharge)
 		/* This is not "cancel", but cancel_charge does all we need. */
@@ -4077,6 +4134,8 @@ enum {
 	MCS_CACHE,
 	MCS_RSS,
 	MCS_FILE_MAPPED,
+	MCS_FILE_DIRTY,
+	MCS_WRITEBACK,
 	MCS_PGPGIN,
 	MCS_PGPGOUT,
 	MCS_SWAP,
@@ -4101,6 +4160,8 @@ struct {
 	{"cache", "total_cache"},
 	{"rss", "total_rss"},
 	{"mapped_file", "total_mapped_file"},
+	{"dirty", "total_dirty"},
+	{"writeback", "total_writeback"},
 	{"pgpgin", "total_pgpgin"},
 	{"pgpgout", "total_pgpgout"},
 	{"swap", "total_swap"},
@@ -4126,6 +4187,10 @@ mem_cgroup_get_local_stat(struct mem_cgroup *memcg, struct mcs_total_stat *s)
 	s->stat[MCS_RSS] += val * PAGE_SIZE;
 	val = mem_cgroup_read_stat(memcg, MEM_CGROUP_STAT_FILE_MAPPED);
 	s->stat[MCS_FILE_MAPPED] += val * PAGE_SIZE;
+	val = mem_cgroup_read_stat(memcg, MEM_CGROUP_STAT_FILE_DIRTY);
+	s->stat[MCS_FILE_DIRTY] += val * PAGE_SIZE;
+	val = mem_cgroup_read_stat(memcg, MEM_CGROUP_STAT_FILE_WRITEBACK);
+	s->stat[MCS_WRITEBACK] += val * PAGE_SIZE;
 	val = mem_cgroup_read_events(memcg, MEM_CGROUP_EVENTS_PGPGIN);
 	s->stat[MCS_PGPGIN] += val;
 	val = mem_cgroup_read_events(memcg, MEM_CGROUP_EVENTS_PGPGOUT);
@@ -4309,6 +4374,286 @@ static int mem_cgroup_swappiness_write(struct cgroup *cgrp, struct cftype *cft,
 	return 0;
 }
 
+/*
+ * Dirty page limits.
+ *
+ * The global dirty limits let a single cgroup fill the whole dirty page
+ * budget, after which the writers of every other cgroup get throttled
+ * too.  So each cgroup also has its own dirty limits, relative to the
+ * memory it may use for page cache: its file pages plus its headroom
+ * below limit_in_bytes.  The writers of a cgroup over its limit are
+ * throttled in balance_dirty_pages(), and the flusher writes back the
+ * inodes dirtied by that cgroup.  The root cgroup is only bound by the
+ * global limits.
+ */
+enum {
+	MEM_CGROUP_DIRTY_RATIO,
+	MEM_CGROUP_DIRTY_BYTES,
+	MEM_CGROUP_DIRTY_BACKGROUND_RATIO,
+	MEM_CGROUP_DIRTY_BACKGROUND_BYTES,
+};
+
+/*
+ * Unlike mem_cgroup_read_stat() this does not sleep, the flusher calls it
+ * under wb->list_lock.  A cpu going offline meanwhile may be missed, which
+ * is fine for the dirty limits.
+ */
+static unsigned long mem_cgroup_dirty_stat(struct mem_cgroup *memcg,
+					   enum mem_cgroup_stat_index idx)
+{
+	struct mem_cgroup *iter;
+	long val = 0;
+	int cpu;
+
+	for_each_mem_cgroup_tree(iter, memcg) {
+		for_each_online_cpu(cpu)
+			val += per_cpu(iter->stat->count[idx], cpu);
+#ifdef CONFIG_HOTPLUG_CPU
+		spin_lock(&iter->pcp_counter_lock);
+		val += iter->nocpu_base.count[idx];
+		spin_unlock(&iter->pcp_counter_lock);
+#endif
+	}
+	if (val < 0) /* race ? */
+		val = 0;
+	return val;
+}
+
+/*
+ * Number of pages the cgroup may use for dirty page cache, ULONG_MAX if
+ * it has no memory limit.
+ */
+static unsigned long mem_cgroup_dirtyable_pages(struct mem_cgroup *memcg)
+{
+	struct mem_cgroup *iter;
+	unsigned long file = 0;
+
+	if (res_counter_read_u64(&memcg->res, RES_LIMIT) == RESOURCE_MAX)
+		return ULONG_MAX;
+
+	for_each_mem_cgroup_tree(iter, memcg)
+		file += mem_cgroup_nr_lru_pages(iter, LRU_ALL_FILE);
+
+	return file + (res_counter_margin(&memcg->res) >> PAGE_SHIFT);
+}
+
+/*
+ * Like global_dirty_limits(), for @memcg.  @sys_available is the global
+ * dirtyable memory, a cgroup never gets more than that.
+ */
+static void mem_cgroup_dirty_limits(struct mem_cgroup *memcg,
+				    unsigned long sys_available,
+				    struct mem_cgroup_dirty_info *info)
+{
+	unsigned long available;
+	unsigned long background;
+	unsigned long dirty;
+	struct task_struct *tsk;
+
+	available = min(mem_cgroup_dirtyable_pages(memcg), sys_available);
+
+	if (memcg->dirty_bytes)
+		dirty = DIV_ROUND_UP(memcg->dirty_bytes, PAGE_SIZE);
+	else
+		dirty = (memcg->dirty_ratio * available) / 100;
+
+	if (memcg->dirty_background_bytes)
+		background = DIV_ROUND_UP(memcg->dirty_background_bytes,
+					  PAGE_SIZE);
+	else
+		background = (memcg->dirty_background_ratio * available) / 100;
+
+	if (background >= dirty)
+		background = dirty / 2;
+	tsk = current;
+	if (tsk->flags & PF_LESS_THROTTLE || rt_task(tsk)) {
+		background += background / 4;
+		dirty += dirty / 4;
+	}
+
+	info->dirty_thresh = dirty;
+	info->background_thresh = background;
+	info->nr_dirty = mem_cgroup_dirty_stat(memcg,
+					       MEM_CGROUP_STAT_FILE_DIRTY);
+	info->nr_writeback = mem_cgroup_dirty_stat(memcg,
+					MEM_CGROUP_STAT_FILE_WRITEBACK);
+	info->memcg_id = css_id(&memcg->css);
+}
+
+/**
+ * mem_cgroup_dirty_info - dirty limits of the current task's memory cgroup
+ * @info: filled in with the limits and dirty page counts
+ *
+ * With hierarchical accounting, the cgroup or ancestor closest to its dirty
+ * limit is reported.  Returns false if the task is only subject to the
+ * global dirty limits.
+ */
+bool mem_cgroup_dirty_info(struct mem_cgroup_dirty_info *info)
+{
+	struct mem_cgroup_dirty_info cur;
+	struct mem_cgroup *memcg, *iter;
+	unsigned long sys_available;
+	long margin, best = LONG_MAX;
+	bool ret = false;
+
+	if (mem_cgroup_disabled())
+		return false;
+
+	rcu_read_lock();
+	memcg = mem_cgroup_from_task(current);
+	if (!memcg || mem_cgroup_is_root(memcg) || !css_tryget(&memcg->css)) {
+		rcu_read_unlock();
+		return false;
+	}
+	rcu_read_unlock();
+
+	sys_available = determine_dirtyable_memory();
+	for (iter = memcg; iter && !mem_cgroup_is_root(iter);
+	     iter = parent_mem_cgroup(iter)) {
+		mem_cgroup_dirty_limits(iter, sys_available, &cur);
+		margin = (long)cur.dirty_thresh -
+			 (long)(cur.nr_dirty + cur.nr_writeback);
+		if (margin < best) {
+			best = margin;
+			*info = cur;
+			ret = true;
+		}
+	}
+	css_put(&memcg->css);
+
+	return ret;
+}
+
+/*
+ * Whether the cgroup with css id @memcg_id still has more dirty pages than
+ * its background threshold.  Called by the flusher writing back on behalf
+ * of the cgroup.
+ */
+bool mem_cgroup_over_bground_thresh(unsigned short memcg_id)
+{
+	struct mem_cgroup_dirty_info info;
+	struct mem_cgroup *memcg;
+
+	rcu_read_lock();
+	memcg = mem_cgroup_lookup(memcg_id);
+	if (memcg && !css_tryget(&memcg->css))
+		memcg = NULL;
+	rcu_read_unlock();
+	if (!memcg)
+		return false;
+
+	mem_cgroup_dirty_limits(memcg, determine_dirtyable_memory(), &info);
+	css_put(&memcg->css);
+
+	return info.nr_dirty > info.background_thresh;
+}
+
+/*
+ * Whether @inode was last dirtied by the cgroup with css id @memcg_id, or
+ * by one of its descendants under hierarchical accounting.
+ */
+bool mem_cgroup_inode_dirtied_by(struct inode *inode, unsigned short memcg_id)
+{
+	unsigned short id = ACCESS_ONCE(inode->i_mapping->i_memcg);
+	struct mem_cgroup *memcg, *root;
+	bool ret = false;
+
+	if (id == memcg_id)
+		return true;
+
+	rcu_read_lock();
+	memcg = mem_cgroup_lookup(id);
+	root = mem_cgroup_lookup(memcg_id);
+	if (memcg && root)
+		ret = mem_cgroup_same_or_subtree(root, memcg);
+	rcu_read_unlock();
+
+	return ret;
+}
+
+/* New cgroups start with the limits of their parent */
+static void mem_cgroup_dirty_init(struct mem_cgroup *memcg,
+				  struct mem_cgroup *parent)
+{
+	if (mem_cgroup_is_root(parent)) {
+		memcg->dirty_ratio = vm_dirty_ratio;
+		memcg->dirty_bytes = vm_dirty_bytes;
+		memcg->dirty_background_ratio = dirty_background_ratio;
+		memcg->dirty_background_bytes = dirty_background_bytes;
+	} else {
+		memcg->dirty_ratio = parent->dirty_ratio;
+		memcg->dirty_bytes = parent->dirty_bytes;
+		memcg->dirty_background_ratio = parent->dirty_background_ratio;
+		memcg->dirty_background_bytes = parent->dirty_background_bytes;
+	}
+}
+
+static u64 mem_cgroup_dirty_read(struct cgroup *cgrp, struct cftype *cft)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_cont(cgrp);
+	bool root = cgrp->parent == NULL;
+
+	switch (cft->private) {
+	case MEM_CGROUP_DIRTY_RATIO:
+		return root ? vm_dirty_ratio : memcg->dirty_ratio;
+	case MEM_CGROUP_DIRTY_BYTES:
+		return root ? vm_dirty_bytes : memcg->dirty_bytes;
+	case MEM_CGROUP_DIRTY_BACKGROUND_RATIO:
+		return root ? dirty_background_ratio :
+			      memcg->dirty_background_ratio;
+	case MEM_CGROUP_DIRTY_BACKGROUND_BYTES:
+		return root ? dirty_background_bytes :
+			      memcg->dirty_background_bytes;
+	default:
+		BUG();
+	}
+}
+
+/*
+ * As with the vm.dirty_* sysctls, setting a ratio clears the corresponding
+ * bytes limit and the other way round.
+ */
+static int mem_cgroup_dirty_write(struct cgroup *cgrp, struct cftype *cft,
+				  u64 val)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_cont(cgrp);
+
+	/* The root cgroup follows the sysctls */
+	if (cgrp->parent == NULL)
+		return -EINVAL;
+
+	switch (cft->private) {
+	case MEM_CGROUP_DIRTY_RATIO:
+		if (val > 100)
+			return -EINVAL;
+		memcg->dirty_ratio = val;
+		memcg->dirty_bytes = 0;
+		break;
+	case MEM_CGROUP_DIRTY_BYTES:
+		if (val < 2 * PAGE_SIZE || val > ULONG_MAX)
+			return -EINVAL;
+		memcg->dirty_bytes = val;
+		memcg->dirty_ratio = 0;
+		break;
+	case MEM_CGROUP_DIRTY_BACKGROUND_RATIO:
+		if (val > 100)
+			return -EINVAL;
+		memcg->dirty_background_ratio = val;
+		memcg->dirty_background_bytes = 0;
+		break;
+	case MEM_CGROUP_DIRTY_BACKGROUND_BYTES:
+		if (val < 1 || val > ULONG_MAX)
+			return -EINVAL;
+		memcg->dirty_background_bytes = val;
+		memcg->dirty_background_ratio = 0;
+		break;
+	default:
+		BUG();
+	}
+
+	return 0;
+}
+
 static void __mem_cgroup_threshold(struct mem_cgroup *memcg, bool swap)
 {
 	struct mem_cgroup_threshold_ary *t;
@@ -4649,6 +4994,32 @@ static int mem_cgroup_oom_control_write(struct cgroup *cgrp,
 	return 0;
 }
 
+struct vmpressure *memcg_to_vmpressure(struct mem_cgroup *memcg)
+{
+	/* Global reclaim puts pressure on the root cgroup */
+	if (!memcg)
+		memcg = root_mem_cgroup;
+	if (!memcg || mem_cgroup_disabled())
+		return NULL;
+	return &memcg->vmpressure;
+}
+
+struct vmpressure *cg_to_vmpressure(struct cgroup *cg)
+{
+	return &mem_cgroup_from_cont(cg)->vmpressure;
+}
+
+struct vmpressure *vmpressure_parent(struct vmpressure *vmpr)
+{
+	struct mem_cgroup *memcg;
+
+	memcg = container_of(vmpr, struct mem_cgroup, vmpressure);
+	memcg = parent_mem_cgroup(memcg);
+	if (!memcg)
+		return NULL;
+	return &memcg->vmpressure;
+}
+
 #ifdef CONFIG_NUMA
 static const struct file_operations mem_control_numa_stat_file_operations = {
 	.read = seq_read,
@@ -4715,6 +5086,30 @@ static struct cftype mem_cgroup_files[] = {
 		.read_u64 = mem_cgroup_swappiness_read,
 		.write_u64 = mem_cgroup_swappiness_write,
 	},
+	{
+		.name = "dirty_ratio",
+		.read_u64 = mem_cgroup_dirty_read,
+		.write_u64 = mem_cgroup_dirty_write,
+		.private = MEM_CGROUP_DIRTY_RATIO,
+	},
+	{
+		.name = "dirty_bytes",
+		.read_u64 = mem_cgroup_dirty_read,
+		.write_u64 = mem_cgroup_dirty_write,
+		.private = MEM_CGROUP_DIRTY_BYTES,
+	},
+	{
+		.name = "dirty_background_ratio",
+		.read_u64 = mem_cgroup_dirty_read,
+		.write_u64 = mem_cgroup_dirty_write,
+		.private = MEM_CGROUP_DIRTY_BACKGROUND_RATIO,
+	},
+	{
+		.name = "dirty_background_bytes",
+		.read_u64 = mem_cgroup_dirty_read,
+		.write_u64 = mem_cgroup_dirty_write,
+		.private = MEM_CGROUP_DIRTY_BACKGROUND_BYTES,
+	},
 	{
 		.name = "move_charge_at_immigrate",
 		.read_u64 = mem_cgroup_move_charge_read,
@@ -4728,6 +5123,12 @@ static struct cftype mem_cgroup_files[] = {
 		.unregister_event = mem_cgroup_oom_unregister_event,
 		.private = MEMFILE_PRIVATE(_OOM_TYPE, OOM_CONTROL),
 	},
+	{
+		.name = "pressure_level",
+		.register_event = vmpressure_register_event,
+		.unregister_event = vmpressure_unregister_event,
+		.mode = S_IRUGO,
+	},
 #ifdef CONFIG_NUMA
 	{
 		.name = "numa_stat",
@@ -4860,6 +5261,7 @@ static void __mem_cgroup_free(struct mem_cgroup *memcg)
 {
 	int node;
 
+	vmpressure_cleanup(&memcg->vmpressure);
 	mem_cgroup_remove_from_trees(memcg);
 	free_css_id(&mem_cgroup_subsys, &memcg->css);
 
@@ -4950,6 +5352,7 @@ mem_cgroup_create(struct cgroup_subsys *ss, struct cgroup *cont)
 	memcg = mem_cgroup_alloc();
 	if (!memcg)
 		return ERR_PTR(error);
+	vmpressure_init(&memcg->vmpressure);
 
 	for_each_node_state(node, N_POSSIBLE)
 		if (alloc_mem_cgroup_per_zone_info(memcg, node))
@@ -4993,8 +5396,10 @@ mem_cgroup_create(struct cgroup_subsys *ss, struct cgroup *cont)
 	memcg->last_scanned_node = MAX_NUMNODES;
 	INIT_LIST_HEAD(&memcg->oom_notify);
 
-	if (parent)
+	if (parent) {
 		memcg->swappiness = mem_cgroup_swappiness(parent);
+		mem_cgroup_dirty_init(memcg, parent);
+	}
 	atomic_set(&memcg->refcnt, 1);
 	memcg->move_charge_at_immigrate = 0;
 	mutex_init(&memcg->thresholds_lock);
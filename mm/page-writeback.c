@@ -34,6 +34,7 @@
 #include <linux/syscalls.h>
 #include <linux/buffer_head.h>
 #include <linux/pagevec.h>
+#include <linux/memcontrol.h>
 #include <trace/events/writeback.h>
 
 /*
@@ -1202,6 +1203,64 @@ pause:
 		bdi_start_background_writeback(bdi);
 }
 
+/*
+ * The dirty limits of the task's memory cgroup, on top of the global ones
+ * enforced by balance_dirty_pages().  Above the freerun ceiling the flusher
+ * is asked to write back the cgroup's inodes, and the task is slowed down
+ * more the closer the cgroup gets to its limit, from the device's write
+ * bandwidth at the ceiling down to nothing at the limit.  Above the limit
+ * it waits for writeback to catch up.
+ */
+static void balance_memcg_dirty_pages(struct address_space *mapping,
+				      unsigned long pages_dirtied)
+{
+	struct mem_cgroup_dirty_info info;
+	struct backing_dev_info *bdi = mapping->backing_dev_info;
+	unsigned long nr_dirty;	/* = file_dirty + writeback */
+	unsigned long freerun;
+	unsigned long task_ratelimit;
+	long pause, max_pause;
+
+	for (;;) {
+		if (!mem_cgroup_dirty_info(&info))
+			return;
+
+		nr_dirty = info.nr_dirty + info.nr_writeback;
+		freerun = dirty_freerun_ceiling(info.dirty_thresh,
+						info.background_thresh);
+
+		/* even in the freerun range, get the flusher going */
+		if (info.nr_dirty > info.background_thresh)
+			bdi_start_memcg_writeback(bdi, info.memcg_id);
+		if (nr_dirty <= freerun)
+			break;
+
+		max_pause = bdi_max_pause(bdi, nr_dirty);
+		if (nr_dirty < info.dirty_thresh) {
+			task_ratelimit = div_u64((u64)bdi->avg_write_bandwidth *
+						 (info.dirty_thresh - nr_dirty),
+						 info.dirty_thresh - freerun);
+			pause = HZ * pages_dirtied / (task_ratelimit + 1);
+			pause = min(pause, max_pause);
+		} else
+			pause = max_pause;
+
+		if (pause <= 0)
+			break;
+		__set_current_state(TASK_KILLABLE);
+		io_schedule_timeout(pause);
+
+		if (nr_dirty < info.dirty_thresh)
+			break;
+		if (fatal_signal_pending(current))
+			break;
+	}
+
+	/* Check back before the cgroup can run past its limit */
+	current->nr_dirtied_pause = min(current->nr_dirtied_pause,
+			(int)dirty_poll_interval(nr_dirty, info.dirty_thresh));
+}
+
 void set_page_dirty_balance(struct page *page, int page_mkwrite)
 {
 	if (set_page_dirty(page) || page_mkwrite) {
@@ -1263,8 +1322,12 @@ void balance_dirty_pages_ratelimited_nr(struct address_space *mapping,
 	}
 	preempt_enable();
 
-	if (unlikely(current->nr_dirtied >= ratelimit))
-		balance_dirty_pages(mapping, current->nr_dirtied);
+	if (unlikely(current->nr_dirtied >= ratelimit)) {
+		unsigned long pages_dirtied = current->nr_dirtied;
+
+		balance_dirty_pages(mapping, pages_dirtied);
+		balance_memcg_dirty_pages(mapping, pages_dirtied);
+	}
 }
 EXPORT_SYMBOL(balance_dirty_pages_ratelimited_nr);
 
@@ -1736,6 +1799,7 @@ int __set_page_dirty_no_writeback(struct page *page)
 void account_page_dirtied(struct page *page, struct address_space *mapping)
 {
 	if (mapping_cap_account_dirty(mapping)) {
+		mem_cgroup_inc_page_stat(page, MEMCG_NR_FILE_DIRTY);
 		__inc_zone_page_state(page, NR_FILE_DIRTY);
 		__inc_zone_page_state(page, NR_DIRTIED);
 		__inc_bdi_stat(mapping->backing_dev_info, BDI_RECLAIMABLE);
@@ -1752,6 +1816,7 @@ EXPORT_SYMBOL(account_page_dirtied);
  */
 void account_page_writeback(struct page *page)
 {
+	mem_cgroup_inc_page_stat(page, MEMCG_NR_FILE_WRITEBACK);
 	inc_zone_page_state(page, NR_WRITEBACK);
 }
 EXPORT_SYMBOL(account_page_writeback);
@@ -1934,6 +1999,7 @@ int clear_page_dirty_for_io(struct page *page)
 		 * for more comments.
 		 */
 		if (TestClearPageDirty(page)) {
+			mem_cgroup_dec_page_stat(page, MEMCG_NR_FILE_DIRTY);
 			dec_zone_page_state(page, NR_FILE_DIRTY);
 			dec_bdi_stat(mapping->backing_dev_info,
 					BDI_RECLAIMABLE);
@@ -1970,6 +2036,7 @@ int test_clear_page_writeback(struct page *page)
 		ret = TestClearPageWriteback(page);
 	}
 	if (ret) {
+		mem_cgroup_dec_page_stat(page, MEMCG_NR_FILE_WRITEBACK);
 		dec_zone_page_state(page, NR_WRITEBACK);
 		inc_zone_page_state(page, NR_WRITTEN);
 	}
@@ -245,17 +245,46 @@ unsigned long max_sane_readahead(unsigned long nr)
 		+ node_page_state(numa_node_id(), NR_FREE_PAGES)) / 2);
 }
 
+/*
+ * The largest readahead window for @ra: the per file setting, or the
+ * device's adaptive window if it has one.  Per file adjustments, i.e.
+ * POSIX_FADV_SEQUENTIAL and the shrinking after I/O errors, still apply.
+ */
+unsigned long ra_window_pages(struct address_space *mapping,
+			      struct file_ra_state *ra)
+{
+	struct backing_dev_info *bdi = mapping->backing_dev_info;
+	unsigned long window;
+
+	if (!bdi->ra_adaptive)
+		return ra->ra_pages;
+
+	window = ACCESS_ONCE(bdi->ra_window);
+	if (ra->ra_pages > bdi->ra_pages)
+		window *= 2;
+	else if (ra->ra_pages < bdi->ra_pages)
+		window = min_t(unsigned long, window, ra->ra_pages);
+
+	return window;
+}
+
 /*
  * Submit IO for the read-ahead request in file_ra_state.
  */
 unsigned long ra_submit(struct file_ra_state *ra,
 		       struct address_space *mapping, struct file *filp)
 {
+	struct backing_dev_info *bdi = mapping->backing_dev_info;
 	int actual;
 
 	actual = __do_page_cache_readahead(mapping, filp,
 					ra->start, ra->size, ra->async_size);
 
+	if (actual) {
+		__add_bdi_stat(bdi, BDI_RA_PAGES, actual);
+		bdi_update_readahead(bdi);
+	}
+
 	return actual;
 }
 
@@ -398,7 +427,8 @@ ondemand_readahead(struct address_space *mapping,
 		   bool hit_readahead_marker, pgoff_t offset,
 		   unsigned long req_size)
 {
-	unsigned long max = max_sane_readahead(ra->ra_pages);
+	struct backing_dev_info *bdi = mapping->backing_dev_info;
+	unsigned long max = max_sane_readahead(ra_window_pages(mapping, ra));
 
 	/*
 	 * start of file
@@ -412,12 +442,24 @@ ondemand_readahead(struct address_space *mapping,
 	 */
 	if ((offset == (ra->start + ra->size - ra->async_size) ||
 	     offset == (ra->start + ra->size))) {
+		/* The reader got there before the readahead did */
+		if (!hit_readahead_marker)
+			__inc_bdi_stat(bdi, BDI_RA_MISS);
 		ra->start += ra->size;
 		ra->size = get_next_ra_size(ra, max);
 		ra->async_size = ra->size;
 		goto readit;
 	}
 
+	/*
+	 * A cache miss inside the current window: the pages read ahead
+	 * were reclaimed before they could be used.
+	 */
+	if (!hit_readahead_marker &&
+	    offset > ra->start && offset < ra->start + ra->size)
+		__add_bdi_stat(bdi, BDI_RA_THRASH,
+			       ra->start + ra->size - offset);
+
 	/*
 	 * Hit a marked page without valid readahead state.
 	 * E.g. interleaved reads.
@@ -451,15 +493,19 @@ ondemand_readahead(struct address_space *mapping,
 	/*
 	 * sequential cache miss
 	 */
-	if (offset - (ra->prev_pos >> PAGE_CACHE_SHIFT) <= 1UL)
+	if (offset - (ra->prev_pos >> PAGE_CACHE_SHIFT) <= 1UL) {
+		__inc_bdi_stat(bdi, BDI_RA_MISS);
 		goto initial_readahead;
+	}
 
 	/*
 	 * Query the page cache and look for the traces(cached history pages)
 	 * that a sequential stream would leave behind.
 	 */
-	if (try_context_readahead(mapping, ra, offset, req_size, max))
+	if (try_context_readahead(mapping, ra, offset, req_size, max)) {
+		__inc_bdi_stat(bdi, BDI_RA_MISS);
 		goto readit;
+	}
 
 	/*
 	 * standalone, small random read
@@ -551,6 +597,7 @@ page_cache_async_readahead(struct address_space *mapping,
 		return;
 
 	ClearPageReadahead(page);
+	__inc_bdi_stat(mapping->backing_dev_info, BDI_RA_HIT);
 
 	/*
 	 * Defer asynchronous read-ahead on IO congestion.
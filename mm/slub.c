@@ -2002,6 +2002,11 @@ static inline void flush_slab(struct kmem_cache *s, struct kmem_cache_cpu *c)
 	deactivate_slab(s, c);
 }
 
+#ifndef CONFIG_SMP
+static void drain_magazine(struct kmem_cache *s, struct kmem_cache_cpu *c,
+							int keep);
+#endif
+
 /*
  * Flush cpu slab.
  *
@@ -2012,6 +2017,10 @@ static inline void __flush_cpu_slab(struct kmem_cache *s, int cpu)
 	struct kmem_cache_cpu *c = per_cpu_ptr(s->cpu_slab, cpu);
 
 	if (likely(c)) {
+#ifndef CONFIG_SMP
+		/* Objects go back to their slabs before those are unfrozen */
+		drain_magazine(s, c, 0);
+#endif
 		if (c->page)
 			flush_slab(s, c);
 
@@ -2265,6 +2274,60 @@ new_slab:
 	return object;
 }
 
+#ifndef CONFIG_SMP
+/*
+ * On a uniprocessor kernel only interrupt handlers can run in between the
+ * fastpath's read and update of the per cpu freelist.  Disabling interrupts
+ * around the two is cheaper than the transaction id and the cmpxchg_double,
+ * which has to be emulated by disabling interrupts on most UP machines
+ * anyway.  Disabling preemption alone would not do, slab objects are
+ * allocated and freed from interrupt context.
+ *
+ * Objects freed to a slab other than the cpu slab are not handed back to
+ * their slab right away but kept in a small per cpu magazine and reused
+ * first, while they are still cache hot.  This turns the typical pattern
+ * of a network or block driver, which frees objects allocated long ago,
+ * into fastpath operations.  Objects in a magazine count as allocated.
+ */
+static inline int magazine_match(int node)
+{
+#ifdef CONFIG_NUMA
+	return node == NUMA_NO_NODE;
+#else
+	return 1;
+#endif
+}
+
+static __always_inline void *slab_alloc_up(struct kmem_cache *s,
+		gfp_t gfpflags, int node, unsigned long addr)
+{
+	void **object;
+	struct kmem_cache_cpu *c;
+	unsigned long flags;
+
+	local_irq_save(flags);
+	c = __this_cpu_ptr(s->cpu_slab);
+
+	if (c->nr_magazine && magazine_match(node)) {
+		object = c->magazine[--c->nr_magazine];
+		local_irq_restore(flags);
+		stat(s, ALLOC_MAGAZINE);
+		return object;
+	}
+
+	object = c->freelist;
+	if (unlikely(!object || !node_match(c, node))) {
+		local_irq_restore(flags);
+		return __slab_alloc(s, gfpflags, node, addr, c);
+	}
+
+	c->freelist = get_freepointer(s, object);
+	local_irq_restore(flags);
+	stat(s, ALLOC_FASTPATH);
+	return object;
+}
+#endif
+
 /*
  * Inlined fastpath so that allocation functions (kmalloc, kmem_cache_alloc)
  * have the fastpath folded into their functions. So no function call
@@ -2279,12 +2342,17 @@ static __always_inline void *slab_alloc(struct kmem_cache *s,
 		gfp_t gfpflags, int node, unsigned long addr)
 {
 	void **object;
+#ifdef CONFIG_SMP
 	struct kmem_cache_cpu *c;
 	unsigned long tid;
+#endif
 
 	if (slab_pre_alloc_hook(s, gfpflags))
 		return NULL;
 
+#ifndef CONFIG_SMP
+	object = slab_alloc_up(s, gfpflags, node, addr);
+#else
 redo:
 
 	/*
@@ -2332,6 +2400,7 @@ redo:
 		}
 		stat(s, ALLOC_FASTPATH);
 	}
+#endif
 
 	if (unlikely(gfpflags & __GFP_ZERO) && object)
 		memset(object, 0, s->objsize);
@@ -2416,8 +2485,6 @@ static void __slab_free(struct kmem_cache *s, struct page *page,
 	struct kmem_cache_node *n = NULL;
 	unsigned long uninitialized_var(flags);
 
-	stat(s, FREE_SLOWPATH);
-
 	if (kmem_cache_debug(s) && !free_debug_processing(s, page, x, addr))
 		return;
 
@@ -2517,6 +2584,63 @@ slab_empty:
 	discard_slab(s, page);
 }
 
+#ifndef CONFIG_SMP
+/*
+ * Hand the oldest objects of the magazine back to their slabs, so that
+ * only @keep remain.  Called with interrupts disabled.
+ */
+static void drain_magazine(struct kmem_cache *s, struct kmem_cache_cpu *c,
+							int keep)
+{
+	int i, nr = c->nr_magazine - keep;
+
+	if (nr <= 0)
+		return;
+
+	for (i = 0; i < nr; i++) {
+		void *object = c->magazine[i];
+
+		/* Already counted as FREE_MAGAZINE, not a slowpath free */
+		__slab_free(s, virt_to_head_page(object), object, _RET_IP_);
+	}
+	c->nr_magazine = keep;
+	memmove(c->magazine, c->magazine + nr, keep * sizeof(void *));
+}
+
+static __always_inline void slab_free_up(struct kmem_cache *s,
+			struct page *page, void *x, unsigned long addr)
+{
+	void **object = (void *)x;
+	struct kmem_cache_cpu *c;
+	unsigned long flags;
+
+	local_irq_save(flags);
+	c = __this_cpu_ptr(s->cpu_slab);
+
+	if (likely(page == c->page)) {
+		set_freepointer(s, object, c->freelist);
+		c->freelist = object;
+		local_irq_restore(flags);
+		stat(s, FREE_FASTPATH);
+		return;
+	}
+
+	/* Debug caches must see every free in __slab_free */
+	if (s->cpu_magazine && !kmem_cache_debug(s)) {
+		if (unlikely(c->nr_magazine >= s->cpu_magazine))
+			drain_magazine(s, c, s->cpu_magazine / 2);
+		c->magazine[c->nr_magazine++] = object;
+		local_irq_restore(flags);
+		stat(s, FREE_MAGAZINE);
+		return;
+	}
+
+	local_irq_restore(flags);
+	stat(s, FREE_SLOWPATH);
+	__slab_free(s, page, x, addr);
+}
+#endif
+
 /*
  * Fastpath with forced inlining to produce a kfree and kmem_cache_free that
  * can perform fastpath freeing without additional function calls.
@@ -2531,12 +2655,17 @@ slab_empty:
 static __always_inline void slab_free(struct kmem_cache *s,
 			struct page *page, void *x, unsigned long addr)
 {
+#ifdef CONFIG_SMP
 	void **object = (void *)x;
 	struct kmem_cache_cpu *c;
 	unsigned long tid;
+#endif
 
 	slab_free_hook(s, x);
 
+#ifndef CONFIG_SMP
+	slab_free_up(s, page, x, addr);
+#else
 redo:
 	/*
 	 * Determine the currently cpus per cpu slab.
@@ -2561,9 +2690,11 @@ redo:
 			goto redo;
 		}
 		stat(s, FREE_FASTPATH);
-	} else
+	} else {
+		stat(s, FREE_SLOWPATH);
 		__slab_free(s, page, x, addr);
-
+	}
+#endif
 }
 
 void kmem_cache_free(struct kmem_cache *s, void *x)
@@ -3055,6 +3186,23 @@ static int kmem_cache_open(struct kmem_cache *s,
 	else
 		s->cpu_partial = 30;
 
+#ifndef CONFIG_SMP
+	/*
+	 * Every object held in the cpu magazine keeps its slab from being
+	 * freed, so hold fewer of them the larger they are.
+	 */
+	if (kmem_cache_debug(s))
+		s->cpu_magazine = 0;
+	else if (s->size >= PAGE_SIZE)
+		s->cpu_magazine = 2;
+	else if (s->size >= 1024)
+		s->cpu_magazine = 4;
+	else if (s->size >= 256)
+		s->cpu_magazine = 8;
+	else
+		s->cpu_magazine = SLUB_MAGAZINE_SIZE;
+#endif
+
 	s->refcount = 1;
 #ifdef CONFIG_NUMA
 	s->remote_node_defrag_ratio = 1000;
@@ -4660,6 +4808,33 @@ static ssize_t cpu_partial_store(struct kmem_cache *s, const char *buf,
 }
 SLAB_ATTR(cpu_partial);
 
+#ifndef CONFIG_SMP
+static ssize_t cpu_magazine_show(struct kmem_cache *s, char *buf)
+{
+	return sprintf(buf, "%u\n", s->cpu_magazine);
+}
+
+static ssize_t cpu_magazine_store(struct kmem_cache *s, const char *buf,
+				 size_t length)
+{
+	unsigned long objects;
+	int err;
+
+	err = strict_strtoul(buf, 10, &objects);
+	if (err)
+		return err;
+	if (objects > SLUB_MAGAZINE_SIZE)
+		return -EINVAL;
+	if (objects && kmem_cache_debug(s))
+		return -EINVAL;
+
+	s->cpu_magazine = objects;
+	flush_all(s);
+	return length;
+}
+SLAB_ATTR(cpu_magazine);
+#endif
+
 static ssize_t ctor_show(struct kmem_cache *s, char *buf)
 {
 	if (!s->ctor)
@@ -5053,6 +5228,10 @@ STAT_ATTR(CMPXCHG_DOUBLE_CPU_FAIL, cmpxchg_double_cpu_fail);
 STAT_ATTR(CMPXCHG_DOUBLE_FAIL, cmpxchg_double_fail);
 STAT_ATTR(CPU_PARTIAL_ALLOC, cpu_partial_alloc);
 STAT_ATTR(CPU_PARTIAL_FREE, cpu_partial_free);
+#ifndef CONFIG_SMP
+STAT_ATTR(ALLOC_MAGAZINE, alloc_magazine);
+STAT_ATTR(FREE_MAGAZINE, free_magazine);
+#endif
 #endif
 
 static struct attribute *slab_attrs[] = {
@@ -5062,6 +5241,9 @@ static struct attribute *slab_attrs[] = {
 	&order_attr.attr,
 	&min_partial_attr.attr,
 	&cpu_partial_attr.attr,
+#ifndef CONFIG_SMP
+	&cpu_magazine_attr.attr,
+#endif
 	&objects_attr.attr,
 	&objects_partial_attr.attr,
 	&partial_attr.attr,
@@ -5118,6 +5300,10 @@ static struct attribute *slab_attrs[] = {
 	&cmpxchg_double_cpu_fail_attr.attr,
 	&cpu_partial_alloc_attr.attr,
 	&cpu_partial_free_attr.attr,
+#ifndef CONFIG_SMP
+	&alloc_magazine_attr.attr,
+	&free_magazine_attr.attr,
+#endif
 #endif
 #ifdef CONFIG_FAILSLAB
 	&failslab_attr.attr,
@@ -614,6 +614,9 @@ static char * const migratetype_names[MIGRATE_TYPES] = {
 	"Movable",
 	"Reserve",
 	"Isolate",
+#ifdef CONFIG_CMA
+	"CMA",
+#endif
 };
 
 static void *frag_start(struct seq_file *m, loff_t *pos)
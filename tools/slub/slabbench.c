@@ -0,0 +1,240 @@
+/*
+ * Slabbench: Measure the slab allocator fast and slow paths
+ *
+ * Socket buffers are allocated and freed at a high rate by passing
+ * messages through a unix domain socket pair.  Every message allocates
+ * an skbuff head and a kmalloc'ed data buffer which are freed when the
+ * message is received.  Queueing several messages before reading them
+ * back makes objects get freed after other objects were allocated, as
+ * in a real network stack.
+ *
+ * The time per message is reported together with how the allocations and
+ * frees were satisfied, taken from the counters in /sys/kernel/slab
+ * (needs CONFIG_SLUB_STATS).  On uniprocessor kernels the hits of the per
+ * cpu magazine are shown too; compare with the magazine disabled by
+ *
+ *	echo 0 > /sys/kernel/slab/<cache>/cpu_magazine
+ *
+ * Compile with:
+ *
+ * gcc -O2 -o slabbench slabbench.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <getopt.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+
+#define MAX_SLABS 500
+
+enum {
+	ALLOC_FASTPATH,
+	ALLOC_SLOWPATH,
+	ALLOC_MAGAZINE,
+	FREE_FASTPATH,
+	FREE_SLOWPATH,
+	FREE_MAGAZINE,
+	NR_COUNTERS
+};
+
+static const char *counter_names[NR_COUNTERS] = {
+	"alloc_fastpath",
+	"alloc_slowpath",
+	"alloc_magazine",
+	"free_fastpath",
+	"free_slowpath",
+	"free_magazine",
+};
+
+struct slabcount {
+	char name[sizeof(((struct dirent *)0)->d_name)];
+	unsigned long c[NR_COUNTERS];
+};
+
+static struct slabcount before[MAX_SLABS], after[MAX_SLABS];
+static int have_stats;
+
+static unsigned long read_counter(const char *slab, const char *counter)
+{
+	char path[PATH_MAX], buf[64];
+	FILE *f;
+
+	snprintf(path, sizeof(path), "/sys/kernel/slab/%s/%s", slab, counter);
+	f = fopen(path, "r");
+	if (!f)
+		return 0;
+	if (!fgets(buf, sizeof(buf), f))
+		buf[0] = 0;
+	fclose(f);
+	have_stats = 1;
+	return strtoul(buf, NULL, 10);
+}
+
+/* Snapshot the counters of all caches, aliases are symlinks and skipped */
+static int read_counters(struct slabcount *sc)
+{
+	DIR *dir;
+	struct dirent *de;
+	struct stat st;
+	char path[PATH_MAX];
+	int n = 0, i;
+
+	dir = opendir("/sys/kernel/slab");
+	if (!dir) {
+		perror("/sys/kernel/slab");
+		exit(1);
+	}
+	while ((de = readdir(dir)) && n < MAX_SLABS) {
+		if (de->d_name[0] == '.')
+			continue;
+		snprintf(path, sizeof(path), "/sys/kernel/slab/%s", de->d_name);
+		if (lstat(path, &st) || !S_ISDIR(st.st_mode))
+			continue;
+		snprintf(sc[n].name, sizeof(sc[n].name), "%s", de->d_name);
+		for (i = 0; i < NR_COUNTERS; i++)
+			sc[n].c[i] = read_counter(de->d_name, counter_names[i]);
+		n++;
+	}
+	closedir(dir);
+	return n;
+}
+
+static unsigned long pct(unsigned long part, unsigned long total)
+{
+	return total ? part * 100 / total : 0;
+}
+
+static struct slabcount *find_before(int n, const char *name)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		if (!strcmp(before[i].name, name))
+			return &before[i];
+	return NULL;
+}
+
+static void report(int nr_before, int n, unsigned long messages)
+{
+	int i, j;
+
+	printf("\n%-21s %10s %4s %4s %4s %10s %4s %4s %4s\n",
+		"Cache", "Allocs", "Fst%", "Mag%", "Slw%",
+		"Frees", "Fst%", "Mag%", "Slw%");
+	for (i = 0; i < n; i++) {
+		struct slabcount *b = find_before(nr_before, after[i].name);
+		unsigned long d[NR_COUNTERS], allocs, frees;
+
+		for (j = 0; j < NR_COUNTERS; j++)
+			d[j] = after[i].c[j] - (b ? b->c[j] : 0);
+		allocs = d[ALLOC_FASTPATH] + d[ALLOC_SLOWPATH] +
+				d[ALLOC_MAGAZINE];
+		frees = d[FREE_FASTPATH] + d[FREE_SLOWPATH] + d[FREE_MAGAZINE];
+
+		/* Only the caches the benchmark kept busy */
+		if (allocs + frees < messages / 2)
+			continue;
+
+		printf("%-21s %10lu %4lu %4lu %4lu %10lu %4lu %4lu %4lu\n",
+			after[i].name,
+			allocs, pct(d[ALLOC_FASTPATH], allocs),
+			pct(d[ALLOC_MAGAZINE], allocs),
+			pct(d[ALLOC_SLOWPATH], allocs),
+			frees, pct(d[FREE_FASTPATH], frees),
+			pct(d[FREE_MAGAZINE], frees),
+			pct(d[FREE_SLOWPATH], frees));
+	}
+}
+
+static void usage(void)
+{
+	printf("slabbench [-n messages] [-s size] [-b batch]\n\n"
+		"-n|--messages=N   Number of messages to pass (default 1000000)\n"
+		"-s|--size=N       Message size in bytes (default 64)\n"
+		"-b|--batch=N      Messages queued before reading (default 8)\n"
+		"-h|--help         Show this message\n");
+}
+
+static struct option opts[] = {
+	{ "messages", 1, NULL, 'n' },
+	{ "size", 1, NULL, 's' },
+	{ "batch", 1, NULL, 'b' },
+	{ "help", 0, NULL, 'h' },
+	{ NULL, 0, NULL, 0 }
+};
+
+int main(int argc, char *argv[])
+{
+	unsigned long messages = 1000000, size = 64, batch = 8, i, j;
+	struct timespec t0, t1;
+	int sv[2], c, nr_before, n;
+	char *buf;
+	double ns;
+
+	while ((c = getopt_long(argc, argv, "n:s:b:h", opts, NULL)) != -1) {
+		switch (c) {
+		case 'n':
+			messages = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			size = strtoul(optarg, NULL, 0);
+			break;
+		case 'b':
+			batch = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage();
+			exit(c != 'h');
+		}
+	}
+	if (!messages || !size || !batch) {
+		usage();
+		exit(1);
+	}
+
+	buf = calloc(batch, size);
+	if (!buf || socketpair(AF_UNIX, SOCK_STREAM, 0, sv)) {
+		perror("slabbench");
+		exit(1);
+	}
+
+	nr_before = read_counters(before);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < messages; i += batch) {
+		size_t done = 0;
+
+		for (j = 0; j < batch; j++)
+			if (write(sv[0], buf, size) != (ssize_t)size) {
+				perror("write");
+				exit(1);
+			}
+		while (done < batch * size) {
+			ssize_t r = read(sv[1], buf, batch * size - done);
+
+			if (r <= 0) {
+				perror("read");
+				exit(1);
+			}
+			done += r;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	n = read_counters(after);
+
+	ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / i;
+	printf("%lu messages of %lu bytes, %lu queued: %.1f ns/message\n",
+		i, size, batch, ns);
+
+	if (have_stats)
+		report(nr_before, n, i);
+	else
+		printf("No slab statistics, kernel built without CONFIG_SLUB_STATS?\n");
+
+	return 0;
+}
@@ -43,6 +43,7 @@ struct slabinfo {
 	unsigned long cmpxchg_double_cpu_fail, cmpxchg_double_fail;
 	unsigned long alloc_node_mismatch, deactivate_bypass;
 	unsigned long cpu_partial_alloc, cpu_partial_free;
+	unsigned long alloc_magazine, free_magazine;
 	int numa[MAX_NODES];
 	int numa_partial[MAX_NODES];
 } slabinfo[MAX_SLABS];
@@ -330,7 +331,8 @@ static unsigned long slab_size(struct slabinfo *s)
 static unsigned long slab_activity(struct slabinfo *s)
 {
 	return 	s->alloc_fastpath + s->free_fastpath +
-		s->alloc_slowpath + s->free_slowpath;
+		s->alloc_slowpath + s->free_slowpath +
+		s->alloc_magazine + s->free_magazine;
 }
 
 static void slab_numa(struct slabinfo *s, int mode)
@@ -425,8 +427,8 @@ static void slab_stats(struct slabinfo *s)
 	if (!s->alloc_slab)
 		return;
 
-	total_alloc = s->alloc_fastpath + s->alloc_slowpath;
-	total_free = s->free_fastpath + s->free_slowpath;
+	total_alloc = s->alloc_fastpath + s->alloc_slowpath + s->alloc_magazine;
+	total_free = s->free_fastpath + s->free_slowpath + s->free_magazine;
 
 	if (!total_alloc)
 		return;
@@ -439,9 +441,14 @@ static void slab_stats(struct slabinfo *s)
 		s->alloc_fastpath * 100 / total_alloc,
 		s->free_fastpath * 100 / total_free);
 	printf("Slowpath             %8lu %8lu %3lu %3lu\n",
-		total_alloc - s->alloc_fastpath, s->free_slowpath,
-		(total_alloc - s->alloc_fastpath) * 100 / total_alloc,
+		s->alloc_slowpath, s->free_slowpath,
+		s->alloc_slowpath * 100 / total_alloc,
 		s->free_slowpath * 100 / total_free);
+	if (s->alloc_magazine || s->free_magazine)
+		printf("Cpu magazine         %8lu %8lu %3lu %3lu\n",
+			s->alloc_magazine, s->free_magazine,
+			s->alloc_magazine * 100 / total_alloc,
+			s->free_magazine * 100 / total_free);
 	printf("Page Alloc           %8lu %8lu %3lu %3lu\n",
 		s->alloc_slab, s->free_slab,
 		s->alloc_slab * 100 / total_alloc,
@@ -592,14 +599,18 @@ static void slabcache(struct slabinfo *s)
 		unsigned long total_alloc;
 		unsigned long total_free;
 
-		total_alloc = s->alloc_fastpath + s->alloc_slowpath;
-		total_free = s->free_fastpath + s->free_slowpath;
+		total_alloc = s->alloc_fastpath + s->alloc_slowpath +
+				s->alloc_magazine;
+		total_free = s->free_fastpath + s->free_slowpath +
+				s->free_magazine;
 
 		printf("%-21s %8ld %10ld %10ld %3ld %3ld %5ld %1d %4ld %4ld\n",
 			s->name, s->objects,
 			total_alloc, total_free,
-			total_alloc ? (s->alloc_fastpath * 100 / total_alloc) : 0,
-			total_free ? (s->free_fastpath * 100 / total_free) : 0,
+			total_alloc ? ((s->alloc_fastpath + s->alloc_magazine) *
+						100 / total_alloc) : 0,
+			total_free ? ((s->free_fastpath + s->free_magazine) *
+						100 / total_free) : 0,
 			s->order_fallback, s->order, s->cmpxchg_double_fail,
 			s->cmpxchg_double_cpu_fail);
 	}
@@ -1217,6 +1228,8 @@ static void read_slab_dir(void)
 			slab->cmpxchg_double_fail = get_obj("cmpxchg_double_fail");
 			slab->cpu_partial_alloc = get_obj("cpu_partial_alloc");
 			slab->cpu_partial_free = get_obj("cpu_partial_free");
+			slab->alloc_magazine = get_obj("alloc_magazine");
+			slab->free_magazine = get_obj("free_magazine");
 			slab->alloc_node_mismatch = get_obj("alloc_node_mismatch");
 			slab->deactivate_bypass = get_obj("deactivate_bypass");
 			chdir("..");